@@ -5,11 +5,13 @@
 
 #include "frogger_game.h"
 #include "lcd_driver.h"
-#include "driver/gpio.h"
+#include "game_tasks.h"
+#include "game_profile.h"
+#include "frogger_sprites.h"
+#include "ebadge_input.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
-#include "esp_timer.h"
 #include "esp_random.h"
 #include "esp_ota_ops.h"
 #include "esp_partition.h"
@@ -22,10 +24,11 @@ static const char *TAG = "frogger";
 // Game state
 static frogger_state_t game;
 
-// Button state tracking
-static bool button_pressed[6] = {false};
-static uint32_t button_last_press[6] = {0};
-#define BUTTON_DEBOUNCE_MS 150
+// Snapshot being drawn; the render callback reads it during lcd_flush
+static const frogger_state_t *shown;
+
+// Buttons pressed since the last input step
+static ebadge_input_frame_t buttons;
 
 // Level configurations (lanes from bottom to top)
 static const lane_config_t level_lanes[GRID_HEIGHT] = {
@@ -48,17 +51,18 @@ static const lane_config_t level_lanes[GRID_HEIGHT] = {
 
 // Forward declarations
 static void init_buttons(void);
-static bool read_button(int gpio_num, int btn_idx);
 static void init_level(void);
 static void spawn_objects(void);
-static void update_objects(void);
-static void check_collisions(void);
+static void update_objects(float dt);
+static void check_collisions(float dt);
 static void move_frog(int dx, int dy);
 static void kill_frog(void);
 static void draw_lane(int y);
 static void draw_object(game_object_t *obj);
 static void draw_frog(void);
 static void draw_ui(void);
+static void render_scene(void *arg);
+static void invalidate_changes(void);
 static int grid_to_screen_x(int gx);
 static int grid_to_screen_y(int gy);
 
@@ -71,43 +75,32 @@ esp_err_t frogger_init(void) {
     // Initialize buttons
     init_buttons();
     
+    // Frames are composed off-screen and only changed areas are sent
+    lcd_set_renderer(render_scene, NULL);
+    
     // Reset game state
     frogger_reset_game();
     
+    // Initial render: repaint everything on the first flush
+    lcd_invalidate(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    
     ESP_LOGI(TAG, "Game initialized successfully");
     return ESP_OK;
 }
 
 static void init_buttons(void) {
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL<<BTN_UP) | (1ULL<<BTN_DOWN) | 
-                        (1ULL<<BTN_LEFT) | (1ULL<<BTN_RIGHT) |
-                        (1ULL<<BTN_A) | (1ULL<<BTN_B),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
+    // Edges are caught by interrupt and queued for the next input step
+    const ebadge_input_config_t config = {
+        .gpio = {
+            [EBADGE_BUTTON_UP] = BTN_UP,
+            [EBADGE_BUTTON_DOWN] = BTN_DOWN,
+            [EBADGE_BUTTON_LEFT] = BTN_LEFT,
+            [EBADGE_BUTTON_RIGHT] = BTN_RIGHT,
+            [EBADGE_BUTTON_A] = BTN_A,
+            [EBADGE_BUTTON_B] = BTN_B,
+        },
     };
-    gpio_config(&io_conf);
-}
-
-static bool read_button(int gpio_num, int btn_idx) {
-    uint32_t now = esp_timer_get_time() / 1000;  // ms
-    int level = gpio_get_level(gpio_num);
-    
-    if (level == 0) {  // Active low
-        if (!button_pressed[btn_idx]) {
-            if (now - button_last_press[btn_idx] > BUTTON_DEBOUNCE_MS) {
-                button_pressed[btn_idx] = true;
-                button_last_press[btn_idx] = now;
-                ESP_LOGI(TAG, "Button on GPIO %d pressed (idx=%d)", gpio_num, btn_idx);
-                return true;
-            }
-        }
-    } else {
-        button_pressed[btn_idx] = false;
-    }
-    return false;
+    ESP_ERROR_CHECK(ebadge_input_init(&config));
 }
 
 void frogger_reset_game(void) {
@@ -120,6 +113,7 @@ void frogger_reset_game(void) {
     game.game_over = false;
     game.level_complete = false;
     game.paused = false;
+    game.exiting = false;
     game.game_tick = 0;
     game.time_tick = 0;
     game.time_remaining = 60;  // 60 seconds per level
@@ -138,14 +132,6 @@ void frogger_reset_game(void) {
     
     // Initialize level
     init_level();
-    
-    // Clear screen first
-    lcd_fill_screen(COLOR_BLACK);
-    
-    // Draw static background once
-    for (int y = 0; y < GRID_HEIGHT; y++) {
-        draw_lane(y);
-    }
 }
 
 static void init_level(void) {
@@ -225,18 +211,18 @@ static void spawn_objects(void) {
     }
 }
 
-static void update_objects(void) {
+static void update_objects(float dt) {
     for (int i = 0; i < game.object_count; i++) {
         game_object_t *obj = &game.objects[i];
         
         // Move object
         if (obj->dir == DIR_LEFT) {
-            obj->x -= obj->speed * 0.016f;  // Pixels per frame at 60fps
+            obj->x -= obj->speed * dt;  // Speed is in grid cells per second
             if (obj->x + obj->width < 0) {
                 obj->x = GRID_WIDTH;
             }
         } else {
-            obj->x += obj->speed * 0.016f;
+            obj->x += obj->speed * dt;
             if (obj->x > GRID_WIDTH) {
                 obj->x = -obj->width;
             }
@@ -244,7 +230,7 @@ static void update_objects(void) {
     }
 }
 
-static void check_collisions(void) {
+static void check_collisions(float dt) {
     if (!game.frog.alive) return;
     
     int frog_y = game.frog.y;
@@ -266,9 +252,9 @@ static void check_collisions(void) {
                     
                     // Move with platform
                     if (obj->dir == DIR_LEFT) {
-                        game.frog.x -= obj->speed * 0.016f;
+                        game.frog.x -= obj->speed * dt;
                     } else {
-                        game.frog.x += obj->speed * 0.016f;
+                        game.frog.x += obj->speed * dt;
                     }
                     
                     // Check if pushed off screen
@@ -368,6 +354,7 @@ static void kill_frog(void) {
     }
 }
 
+// Runs on the render task, which owns the display
 static void return_to_launcher(void) {
     ESP_LOGI(TAG, "Returning to launcher...");
     
@@ -396,17 +383,20 @@ static void return_to_launcher(void) {
 }
 
 void frogger_handle_input(void) {
+    ebadge_input_frame(&buttons);
+    if (game.exiting) return;
+    
     if (game.game_over) {
-        if (read_button(BTN_B, 5)) {
+        if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_B)) {
             ESP_LOGI(TAG, "Button B pressed - returning to launcher");
-            return_to_launcher();
+            game.exiting = true;
         }
         return;
     }
     
     if (game.level_complete) {
         // Button A - Next level
-        if (read_button(BTN_A, 4)) {
+        if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_A)) {
             game.level++;
             game.level_complete = false;
             game.time_remaining = 60;
@@ -416,55 +406,59 @@ void frogger_handle_input(void) {
             init_level();
         }
         // Button B - Return to launcher
-        if (read_button(BTN_B, 5)) {
-            return_to_launcher();
+        if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_B)) {
+            game.exiting = true;
         }
         return;
     }
     
     if (game.paused) {
         // Button A - unpause
-        if (read_button(BTN_A, 4)) {
+        if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_A)) {
             game.paused = false;
         }
         // Button B - return to launcher
-        if (read_button(BTN_B, 5)) {
-            return_to_launcher();
+        if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_B)) {
+            game.exiting = true;
+        }
+        // Button UP - frame profiler overlay
+        if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_UP)) {
+            game_profile_toggle_overlay();
         }
         return;
     }
     
     // Movement
-    if (read_button(BTN_UP, 0)) {
+    if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_UP)) {
         ESP_LOGI(TAG, "UP pressed - moving frog");
         move_frog(0, 1);
     }
-    else if (read_button(BTN_DOWN, 1)) {
+    else if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_DOWN)) {
         ESP_LOGI(TAG, "DOWN pressed - moving frog");
         move_frog(0, -1);
     }
-    else if (read_button(BTN_LEFT, 2)) {
+    else if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_LEFT)) {
         ESP_LOGI(TAG, "LEFT pressed - moving frog");
         move_frog(-1, 0);
     }
-    else if (read_button(BTN_RIGHT, 3)) {
+    else if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_RIGHT)) {
         ESP_LOGI(TAG, "RIGHT pressed - moving frog");
         move_frog(1, 0);
     }
     
     // Pause game (Button B during gameplay)
-    if (read_button(BTN_B, 5)) {
+    if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_B)) {
         ESP_LOGI(TAG, "Button B pressed - pausing game");
         game.paused = true;
     }
 }
 
-void frogger_update(void) {
+void frogger_update(float dt) {
     if (game.game_over || game.level_complete || game.paused) return;
     
     game.game_tick++;
     
-    // Update timer (every 60 ticks = 1 second)
+    // Update timer (every 60 steps = 1 second)
     if (game.game_tick % 60 == 0) {
         if (game.time_remaining > 0) {
             game.time_remaining--;
@@ -474,10 +468,10 @@ void frogger_update(void) {
     }
     
     // Update objects
-    update_objects();
+    update_objects(dt);
     
     // Check collisions
-    check_collisions();
+    check_collisions(dt);
     
     // Animation
     if (game.game_tick % 15 == 0) {
@@ -485,43 +479,80 @@ void frogger_update(void) {
     }
 }
 
-void frogger_render(void) {
-    // Track last frog position to clear trails
-    static int last_frog_x = -1;
-    static int last_frog_y = -1;
-    
-    // Clear old frog position if it moved
-    if (last_frog_x >= 0 && (last_frog_x != game.frog.x || last_frog_y != game.frog.y)) {
-        int last_sy = grid_to_screen_y(last_frog_y);
-        // Get lane color to clear with
-        lane_type_t type = game.lanes[last_frog_y].type;
-        uint16_t color = (type == LANE_ROAD) ? COLOR_GRAY : 
-                        (type == LANE_RIVER) ? COLOR_BLUE : COLOR_DARK_GREEN;
-        int last_sx = grid_to_screen_x(last_frog_x);
-        lcd_fill_rect(last_sx, last_sy, GRID_SIZE, GRID_SIZE, color);
+void frogger_snapshot(frogger_state_t *frame) {
+    *frame = game;
+}
+
+void frogger_render(const frogger_state_t *frame) {
+    if (frame->exiting) {
+        return_to_launcher();
+        return;
     }
+    shown = frame;
     
-    // Draw frog at new position
-    if (game.frog.alive) {
+    invalidate_changes();
+    lcd_flush();
+}
+
+// Full scene, recorded by lcd_flush once per frame
+static void render_scene(void *arg) {
+    for (int y = 0; y < GRID_HEIGHT; y++) {
+        draw_lane(y);
+    }
+    if (shown->frog.alive) {
         draw_frog();
-        last_frog_x = game.frog.x;
-        last_frog_y = game.frog.y;
-    } else {
-        last_frog_x = -1;
-        last_frog_y = -1;
+    }
+    draw_ui();
+    game_profile_draw_overlay();
+}
+
+// Mark the screen areas whose contents changed since the last frame
+static void invalidate_changes(void) {
+    static int drawn_frog_x, drawn_frog_y;
+    static bool drawn_frog_alive;
+    static bool drawn_goals[5];
+    static uint32_t drawn_score, drawn_time;
+    static uint8_t drawn_lives, drawn_level;
+    static bool drawn_game_over, drawn_level_complete, drawn_paused;
+    
+    if (drawn_frog_x != shown->frog.x || drawn_frog_y != shown->frog.y ||
+        drawn_frog_alive != shown->frog.alive) {
+        lcd_invalidate(grid_to_screen_x(drawn_frog_x), grid_to_screen_y(drawn_frog_y),
+                       GRID_SIZE, GRID_SIZE);
+        lcd_invalidate(grid_to_screen_x(shown->frog.x), grid_to_screen_y(shown->frog.y),
+                       GRID_SIZE, GRID_SIZE);
+        drawn_frog_x = shown->frog.x;
+        drawn_frog_y = shown->frog.y;
+        drawn_frog_alive = shown->frog.alive;
+    }
+    
+    if (memcmp(drawn_goals, shown->goals, sizeof(shown->goals)) != 0) {
+        // Goal slots live in the top lane
+        lcd_invalidate(0, grid_to_screen_y(14), SCREEN_WIDTH, GRID_SIZE);
+        memcpy(drawn_goals, shown->goals, sizeof(shown->goals));
     }
     
-    // Update UI only every 10 frames to save time
-    static int ui_counter = 0;
-    if (++ui_counter >= 10) {
-        ui_counter = 0;
-        draw_ui();
+    if (drawn_score != shown->score || drawn_time != shown->time_remaining ||
+        drawn_lives != shown->lives || drawn_level != shown->level) {
+        lcd_invalidate(0, 0, SCREEN_WIDTH, UI_HEIGHT);
+        drawn_score = shown->score;
+        drawn_time = shown->time_remaining;
+        drawn_lives = shown->lives;
+        drawn_level = shown->level;
+    }
+    
+    if (drawn_game_over != shown->game_over || drawn_level_complete != shown->level_complete ||
+        drawn_paused != shown->paused) {
+        lcd_invalidate(40, SCREEN_HEIGHT/2 - 30, 160, 70);
+        drawn_game_over = shown->game_over;
+        drawn_level_complete = shown->level_complete;
+        drawn_paused = shown->paused;
     }
 }
 
 static void draw_lane(int y) {
     int sy = grid_to_screen_y(y);
-    lane_type_t type = game.lanes[y].type;
+    lane_type_t type = shown->lanes[y].type;
     uint16_t color;
     
     switch (type) {
@@ -550,7 +581,7 @@ static void draw_lane(int y) {
             int gx = i * 3 + 1;
             int gsx = grid_to_screen_x(gx);
             lcd_fill_rect(gsx, sy, GRID_SIZE * 2, GRID_SIZE, 
-                         game.goals[i] ? COLOR_YELLOW : COLOR_DARK_GREEN);
+                         shown->goals[i] ? COLOR_YELLOW : COLOR_DARK_GREEN);
             lcd_draw_rect(gsx, sy, GRID_SIZE * 2, GRID_SIZE, COLOR_WHITE);
         }
     }
@@ -582,23 +613,8 @@ static void draw_object(game_object_t *obj) {
 }
 
 static void draw_frog(void) {
-    int sx = grid_to_screen_x(game.frog.x);
-    int sy = grid_to_screen_y(game.frog.y);
-    
-    // ULTRA BRIGHT GREEN - use explicit RGB565 value
-    // RGB565: Green = 0b00000_111111_00000 = 0x07E0
-    uint16_t bright_green = 0x07E0;
-    
-    // Large filled square with bright green
-    lcd_fill_rect(sx + 1, sy + 1, GRID_SIZE - 2, GRID_SIZE - 2, bright_green);
-    
-    // Thick white border to make it stand out
-    lcd_draw_rect(sx, sy, GRID_SIZE, GRID_SIZE, 0xFFFF);
-    lcd_draw_rect(sx + 1, sy + 1, GRID_SIZE - 2, GRID_SIZE - 2, 0xFFFF);
-    
-    // Big yellow eyes
-    lcd_fill_rect(sx + 3, sy + 3, 4, 4, 0xFFE0);
-    lcd_fill_rect(sx + GRID_SIZE - 7, sy + 3, 4, 4, 0xFFE0);
+    // Bright green with a white border and yellow eyes
+    lcd_draw_sprite(grid_to_screen_x(shown->frog.x), grid_to_screen_y(shown->frog.y), &sprite_frog);
 }
 
 static void draw_ui(void) {
@@ -608,37 +624,37 @@ static void draw_ui(void) {
     lcd_fill_rect(0, 0, SCREEN_WIDTH, UI_HEIGHT, COLOR_BLACK);
     
     // Score
-    snprintf(buf, sizeof(buf), "S:%lu", (unsigned long)game.score);
+    snprintf(buf, sizeof(buf), "S:%lu", (unsigned long)shown->score);
     lcd_draw_string(5, 4, buf, COLOR_WHITE, COLOR_BLACK);
     
     // Lives
-    snprintf(buf, sizeof(buf), "L:%d", game.lives);
+    snprintf(buf, sizeof(buf), "L:%d", shown->lives);
     lcd_draw_string(80, 4, buf, COLOR_WHITE, COLOR_BLACK);
     
     // Time
-    snprintf(buf, sizeof(buf), "T:%lu", (unsigned long)game.time_remaining);
+    snprintf(buf, sizeof(buf), "T:%lu", (unsigned long)shown->time_remaining);
     lcd_draw_string(130, 4, buf, COLOR_WHITE, COLOR_BLACK);
     
     // Level
-    snprintf(buf, sizeof(buf), "LV:%d", game.level);
+    snprintf(buf, sizeof(buf), "LV:%d", shown->level);
     lcd_draw_string(190, 4, buf, COLOR_WHITE, COLOR_BLACK);
     
     // Game state messages
-    if (game.game_over) {
+    if (shown->game_over) {
         lcd_fill_rect(40, SCREEN_HEIGHT/2 - 30, 160, 65, COLOR_BLACK);
         lcd_draw_rect(40, SCREEN_HEIGHT/2 - 30, 160, 65, COLOR_RED);
         lcd_draw_string(70, SCREEN_HEIGHT/2 - 20, "GAME OVER", COLOR_RED, COLOR_BLACK);
-        snprintf(buf, sizeof(buf), "SCORE:%lu", (unsigned long)game.score);
+        snprintf(buf, sizeof(buf), "SCORE:%lu", (unsigned long)shown->score);
         lcd_draw_string(60, SCREEN_HEIGHT/2 - 5, buf, COLOR_WHITE, COLOR_BLACK);
         lcd_draw_string(45, SCREEN_HEIGHT/2 + 10, "Press B to", COLOR_WHITE, COLOR_BLACK);
         lcd_draw_string(40, SCREEN_HEIGHT/2 + 25, "return to menu", COLOR_WHITE, COLOR_BLACK);
-    } else if (game.level_complete) {
+    } else if (shown->level_complete) {
         lcd_fill_rect(40, SCREEN_HEIGHT/2 - 30, 160, 70, COLOR_BLACK);
         lcd_draw_rect(40, SCREEN_HEIGHT/2 - 30, 160, 70, COLOR_GREEN);
         lcd_draw_string(50, SCREEN_HEIGHT/2 - 20, "LEVEL DONE!", COLOR_GREEN, COLOR_BLACK);
         lcd_draw_string(50, SCREEN_HEIGHT/2 - 5, "A: Next level", COLOR_WHITE, COLOR_BLACK);
         lcd_draw_string(50, SCREEN_HEIGHT/2 + 10, "B: Exit to menu", COLOR_WHITE, COLOR_BLACK);
-    } else if (game.paused) {
+    } else if (shown->paused) {
         lcd_fill_rect(40, SCREEN_HEIGHT/2 - 30, 160, 60, COLOR_BLACK);
         lcd_draw_rect(40, SCREEN_HEIGHT/2 - 30, 160, 60, COLOR_YELLOW);
         lcd_draw_string(75, SCREEN_HEIGHT/2 - 20, "PAUSED", COLOR_YELLOW, COLOR_BLACK);
@@ -656,13 +672,31 @@ static int grid_to_screen_y(int gy) {
     return SCREEN_HEIGHT - (gy + 1) * GRID_SIZE;
 }
 
-void frogger_game_loop(void) {
-    static int loop_count = 0;
-    if (++loop_count % 60 == 0) {
-        ESP_LOGI(TAG, "Game loop running... (frame %d)", loop_count);
-    }
-    
+// Logic task: input and one fixed step of simulation
+static void input_step(void *arg) {
     frogger_handle_input();
-    frogger_update();
-    frogger_render();
+}
+
+static void update_step(float dt, void *arg) {
+    frogger_update(dt);
+}
+
+static void snapshot_frame(void *frame, void *arg) {
+    frogger_snapshot(frame);
+}
+
+static void render_frame(const void *frame, void *arg) {
+    frogger_render(frame);
+}
+
+esp_err_t frogger_start(void) {
+    game_tasks_config_t config = {
+        .input = input_step,
+        .update = update_step,
+        .snapshot = snapshot_frame,
+        .render = render_frame,
+        .frame_size = sizeof(frogger_state_t),
+        .tick_hz = 60,
+    };
+    return game_tasks_start(&config);
 }
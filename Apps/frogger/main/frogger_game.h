@@ -125,6 +125,7 @@ typedef struct {
     bool game_over;
     bool level_complete;
     bool paused;
+    bool exiting;      // B pressed to leave; the renderer restarts
     uint32_t game_tick;
     uint32_t time_tick;
 } frogger_state_t;
@@ -138,9 +139,10 @@ typedef struct {
 esp_err_t frogger_init(void);
 
 /**
- * @brief Main game loop (call repeatedly)
+ * @brief Start the logic and render tasks (returns once they run)
+ * @return ESP_OK on success
  */
-void frogger_game_loop(void);
+esp_err_t frogger_start(void);
 
 /**
  * @brief Reset game to initial state
@@ -154,12 +156,19 @@ void frogger_handle_input(void);
 
 /**
  * @brief Update game logic
+ * @param dt Step length in seconds
+ */
+void frogger_update(float dt);
+
+/**
+ * @brief Copy the game state for the renderer. The snapshot the logic task
+ * publishes (see game_tasks.h) is a plain copy of the whole state.
  */
-void frogger_update(void);
+void frogger_snapshot(frogger_state_t *frame);
 
 /**
- * @brief Render the game
+ * @brief Render a snapshot
  */
-void frogger_render(void);
+void frogger_render(const frogger_state_t *frame);
 
 #endif // FROGGER_GAME_H
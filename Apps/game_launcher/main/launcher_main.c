@@ -8,6 +8,7 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
+#include "ebadge_trace.h"
 #include "menu.h"
 
 static const char *TAG = "LAUNCHER";
@@ -24,6 +25,9 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
     
+    // Event trace, dumped by typing "trace" on the console
+    ESP_ERROR_CHECK(ebadge_trace_init());
+    
     // Initialize menu system
     ESP_ERROR_CHECK(menu_init());
     
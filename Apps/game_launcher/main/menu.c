@@ -7,22 +7,21 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_http_client.h"
 #include "esp_ota_ops.h"
 #include "menu.h"
 #include "lcd_driver.h"
+#include "game_profile.h"
+#include "ebadge_input.h"
 
 static const char *TAG = "MENU";
 
 // Global menu state
 static menu_state_t menu_state;
 
-// Button states for debouncing
-static uint8_t btn_state[6] = {1, 1, 1, 1, 1, 1};
-static uint8_t btn_last[6] = {1, 1, 1, 1, 1, 1};
-static uint32_t btn_debounce[6] = {0};
+// Buttons pressed since the last input pass
+static ebadge_input_frame_t buttons;
 
 // Game database - add more games here
 static game_info_t game_database[] = {
@@ -50,47 +49,21 @@ static game_info_t game_database[] = {
 };
 
 /**
- * @brief Initialize button GPIOs
+ * @brief Initialize buttons
  */
 static void init_buttons(void) {
-    gpio_config_t io_conf = {
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
+    // Edges are caught by interrupt and queued for the next input pass
+    const ebadge_input_config_t config = {
+        .gpio = {
+            [EBADGE_BUTTON_UP] = BTN_UP,
+            [EBADGE_BUTTON_DOWN] = BTN_DOWN,
+            [EBADGE_BUTTON_LEFT] = BTN_LEFT,
+            [EBADGE_BUTTON_RIGHT] = BTN_RIGHT,
+            [EBADGE_BUTTON_A] = BTN_A,
+            [EBADGE_BUTTON_B] = BTN_B,
+        },
     };
-    
-    io_conf.pin_bit_mask = (1ULL << BTN_UP) | (1ULL << BTN_DOWN) | 
-                           (1ULL << BTN_LEFT) | (1ULL << BTN_RIGHT) |
-                           (1ULL << BTN_A) | (1ULL << BTN_B);
-    gpio_config(&io_conf);
-}
-
-/**
- * @brief Read button with debouncing
- * @param btn_idx Button index (0-5)
- * @param gpio_num GPIO pin number
- * @return true if button just pressed
- */
-static bool read_button(int btn_idx, int gpio_num) {
-    uint32_t now = xTaskGetTickCount();
-    uint8_t current = gpio_get_level(gpio_num);
-    
-    if (current != btn_last[btn_idx]) {
-        btn_debounce[btn_idx] = now;
-    }
-    btn_last[btn_idx] = current;
-    
-    if ((now - btn_debounce[btn_idx]) > pdMS_TO_TICKS(50)) {
-        if (current != btn_state[btn_idx]) {
-            btn_state[btn_idx] = current;
-            if (current == 0) {  // Button pressed (active low)
-                return true;
-            }
-        }
-    }
-    
-    return false;
+    ESP_ERROR_CHECK(ebadge_input_init(&config));
 }
 
 /**
@@ -185,12 +158,50 @@ static void draw_scrollbar(void) {
                   scrollbar_height, COLOR_CYAN);
 }
 
+/**
+ * @brief Draw the whole menu screen (strip renderer callback)
+ */
+static void render_scene(void *arg) {
+    draw_header();
+    
+    // Draw all visible menu items
+    int visible_items = 3;
+    for (int i = 0; i < visible_items && (i + menu_state.scroll_offset) < menu_state.game_count; i++) {
+        int game_idx = i + menu_state.scroll_offset;
+        int y_pos = MENU_OFFSET_Y + i * MENU_ITEM_HEIGHT;
+        bool selected = (game_idx == menu_state.selected_index);
+        draw_menu_item(game_idx, y_pos, selected);
+    }
+    
+    draw_scrollbar();
+    lcd_draw_string(10, SCREEN_HEIGHT - 45, "BtnA=SELECT", 
+                    COLOR_GRAY, COLOR_BLACK);
+    lcd_draw_string(10, SCREEN_HEIGHT - 25, "BtnB=STATS", 
+                    COLOR_GRAY, COLOR_BLACK);
+    game_profile_draw_overlay();
+}
+
+/**
+ * @brief Mark a menu item's screen area for redraw (if it is visible)
+ */
+static void invalidate_item(int game_idx) {
+    int slot = game_idx - menu_state.scroll_offset;
+    if (slot < 0 || slot >= 3) return;
+    lcd_invalidate(5, MENU_OFFSET_Y + slot * MENU_ITEM_HEIGHT,
+                   SCREEN_WIDTH - 10, MENU_ITEM_HEIGHT - 5);
+}
+
 /**
  * @brief Initialize the menu
  */
 esp_err_t menu_init(void) {
     // Initialize LCD
     lcd_init();
+    lcd_set_renderer(render_scene, NULL);
+    
+    // The visible list is a hardware scroll band between the header and the
+    // button hints, so moving it by an item only redraws the item scrolled in
+    lcd_scroll_region(MENU_OFFSET_Y, 3 * MENU_ITEM_HEIGHT);
     
     // Clear screen twice to flush any garbage from display RAM
     lcd_fill_screen(COLOR_BLACK);
@@ -198,37 +209,9 @@ esp_err_t menu_init(void) {
     lcd_fill_screen(COLOR_BLACK);
     vTaskDelay(pdMS_TO_TICKS(50));  // Wait for second clear
     
-    // Initialize buttons
+    // Initialize buttons; whatever is held now does not count as a press
     init_buttons();
     
-    // Read all button states to initialize button arrays (prevent phantom presses)
-    for (int i = 0; i < 50; i++) {
-        gpio_get_level(BTN_UP);
-        gpio_get_level(BTN_DOWN);
-        gpio_get_level(BTN_LEFT);
-        gpio_get_level(BTN_RIGHT);
-        gpio_get_level(BTN_A);
-        gpio_get_level(BTN_B);
-        vTaskDelay(pdMS_TO_TICKS(1));
-    }
-    
-    // Initialize button states to current GPIO levels
-    btn_state[0] = gpio_get_level(BTN_UP);
-    btn_last[0] = btn_state[0];
-    btn_state[1] = gpio_get_level(BTN_DOWN);
-    btn_last[1] = btn_state[1];
-    btn_state[2] = gpio_get_level(BTN_LEFT);
-    btn_last[2] = btn_state[2];
-    btn_state[3] = gpio_get_level(BTN_RIGHT);
-    btn_last[3] = btn_state[3];
-    btn_state[4] = gpio_get_level(BTN_A);
-    btn_last[4] = btn_state[4];
-    btn_state[5] = gpio_get_level(BTN_B);
-    btn_last[5] = btn_state[5];
-    
-    // Wait a bit more for everything to stabilize
-    vTaskDelay(pdMS_TO_TICKS(100));
-    
     // Load game database
     menu_state.game_count = sizeof(game_database) / sizeof(game_info_t);
     memcpy(menu_state.games, game_database, sizeof(game_database));
@@ -239,6 +222,7 @@ esp_err_t menu_init(void) {
     menu_state.anim_tick = 0;
     menu_state.needs_redraw = true;
     menu_state.last_selected = 0;
+    menu_state.last_scroll_offset = 0;
     menu_state.full_redraw = true;
     
     ESP_LOGI(TAG, "Menu initialized with %d games", menu_state.game_count);
@@ -250,7 +234,9 @@ esp_err_t menu_init(void) {
  * @brief Handle button input
  */
 void menu_handle_input(void) {
-    if (read_button(3, BTN_RIGHT)) {  // RIGHT = move up in menu
+    ebadge_input_frame(&buttons);
+    
+    if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_RIGHT)) {  // RIGHT = move up in menu
         if (menu_state.selected_index > 0) {
             menu_state.selected_index--;
             menu_state.needs_redraw = true;
@@ -258,7 +244,7 @@ void menu_handle_input(void) {
         }
     }
     
-    if (read_button(2, BTN_LEFT)) {  // LEFT = move down in menu
+    if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_LEFT)) {  // LEFT = move down in menu
         if (menu_state.selected_index < menu_state.game_count - 1) {
             menu_state.selected_index++;
             menu_state.needs_redraw = true;
@@ -266,15 +252,16 @@ void menu_handle_input(void) {
         }
     }
     
-    if (read_button(4, BTN_A)) {
+    if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_A)) {
         ESP_LOGI(TAG, "Launching game: %s", 
                  menu_state.games[menu_state.selected_index].name);
         menu_launch_game(menu_state.selected_index);
     }
     
-    if (read_button(5, BTN_B)) {
-        // Could show options/settings menu
-        ESP_LOGI(TAG, "Options button pressed");
+    if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_B)) {
+        // Options button: frame profiler overlay
+        game_profile_toggle_overlay();
+        ESP_LOGI(TAG, "Profiler overlay %s", game_profile_overlay_enabled() ? "on" : "off");
     }
 }
 
@@ -298,53 +285,35 @@ void menu_update(void) {
  * @brief Render the menu
  */
 void menu_render(void) {
-    // Only redraw if something changed
+    // Flushed every frame so the profiler overlay keeps updating; with
+    // nothing invalidated lcd_flush returns straight away
     if (!menu_state.needs_redraw) {
+        lcd_flush();
         return;
     }
     
-    // Full redraw needed (first time or after screen was cleared)
+    // Report what changed; lcd_flush redraws just those areas
     if (menu_state.full_redraw) {
-        lcd_fill_screen(COLOR_BLACK);
-        draw_header();
-        
-        // Draw all visible menu items
-        int visible_items = 3;
-        for (int i = 0; i < visible_items && (i + menu_state.scroll_offset) < menu_state.game_count; i++) {
-            int game_idx = i + menu_state.scroll_offset;
-            int y_pos = MENU_OFFSET_Y + i * MENU_ITEM_HEIGHT;
-            bool selected = (game_idx == menu_state.selected_index);
-            draw_menu_item(game_idx, y_pos, selected);
-        }
-        
-        draw_scrollbar();
-        lcd_draw_string(10, SCREEN_HEIGHT - 45, "BtnA=SELECT", 
-                        COLOR_GRAY, COLOR_BLACK);
-        lcd_draw_string(10, SCREEN_HEIGHT - 25, "BtnB=RETURN", 
-                        COLOR_GRAY, COLOR_BLACK);
+        // First time or after the screen was drawn over
+        lcd_invalidate(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
         menu_state.full_redraw = false;
-    } else {
-        // Only redraw the two changed items
-        int visible_items = 3;
+    } else if (menu_state.last_selected != menu_state.selected_index) {
+        // Visible items move in panel memory; lcd_scroll invalidates the rows
+        // that scroll in
+        lcd_scroll((menu_state.scroll_offset - menu_state.last_scroll_offset) * MENU_ITEM_HEIGHT);
         
-        // Redraw previously selected item (now unselected)
-        if (menu_state.last_selected != menu_state.selected_index) {
-            for (int i = 0; i < visible_items; i++) {
-                int game_idx = i + menu_state.scroll_offset;
-                if (game_idx == menu_state.last_selected) {
-                    int y_pos = MENU_OFFSET_Y + i * MENU_ITEM_HEIGHT;
-                    draw_menu_item(game_idx, y_pos, false);
-                }
-                if (game_idx == menu_state.selected_index) {
-                    int y_pos = MENU_OFFSET_Y + i * MENU_ITEM_HEIGHT;
-                    draw_menu_item(game_idx, y_pos, true);
-                }
-            }
+        // Only the old and new selection changed
+        invalidate_item(menu_state.last_selected);
+        invalidate_item(menu_state.selected_index);
+        if (menu_state.game_count > 3) {
+            lcd_invalidate(SCREEN_WIDTH - 8, MENU_OFFSET_Y, 6, SCREEN_HEIGHT - MENU_OFFSET_Y);
         }
     }
+    lcd_flush();
     
     menu_state.needs_redraw = false;
     menu_state.last_selected = menu_state.selected_index;
+    menu_state.last_scroll_offset = menu_state.scroll_offset;
 }
 
 /**
@@ -407,8 +376,18 @@ void menu_launch_game(int index) {
  * @brief Main menu loop
  */
 void menu_loop(void) {
+    game_profile_begin(GAME_PROFILE_INPUT);
     menu_handle_input();
+    game_profile_end(GAME_PROFILE_INPUT);
+    
+    game_profile_begin(GAME_PROFILE_UPDATE);
     menu_update();
+    game_profile_end(GAME_PROFILE_UPDATE);
+    
+    game_profile_begin(GAME_PROFILE_RENDER);
     menu_render();
+    game_profile_end(GAME_PROFILE_RENDER);
+    game_profile_frame();
+    
     vTaskDelay(pdMS_TO_TICKS(16));  // ~60 FPS
 }
@@ -70,6 +70,7 @@ typedef struct {
     uint32_t anim_tick;
     bool needs_redraw;
     int last_selected;
+    int last_scroll_offset;
     bool full_redraw;  // Force complete redraw
 } menu_state_t;
 
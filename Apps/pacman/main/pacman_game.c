@@ -5,11 +5,15 @@
 
 #include "pacman_game.h"
 #include "lcd_driver.h"
-#include "driver/gpio.h"
+#include "lcd_tilemap.h"
+#include "game_tasks.h"
+#include "game_profile.h"
+#include "pacman_sprites.h"
+#include "pacman_nav.h"
+#include "ebadge_input.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
-#include "esp_timer.h"
 #include "esp_ota_ops.h"
 #include "esp_partition.h"
 #include <string.h>
@@ -21,6 +25,13 @@ static const char *TAG = "pacman";
 // Game state
 static game_state_t game;
 
+// Maze tiles as drawn on screen, each with at most one sprite on top; see
+// TILE_ID
+static lcd_tilemap_t maze_map;
+
+// Snapshot being drawn; the render callback reads it during lcd_flush
+static const game_state_t *shown;
+
 // Classic Pac-Man maze layout (1=wall, 2=dot, 3=power pellet, 0=empty)
 static const uint8_t initial_maze[MAZE_HEIGHT][MAZE_WIDTH] = {
     {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1},
@@ -40,25 +51,79 @@ static const uint8_t initial_maze[MAZE_HEIGHT][MAZE_WIDTH] = {
     {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1},
 };
 
-// Button state tracking
-static bool button_pressed[6] = {false};
-static uint32_t button_last_press[6] = {0};
-#define BUTTON_DEBOUNCE_MS 50
+// Ghosts alternate scatter and chase on a fixed schedule, in 60 Hz ticks
+#define SCATTER_TICKS  (7 * 60)
+#define CHASE_TICKS    (20 * 60)
+
+// Home corner each ghost heads for when scattering
+static const int8_t scatter_corner[4][2] = {{17, 1}, {1, 1}, {17, 13}, {1, 13}};
+
+// Tile offset of one step in each direction
+static const int8_t dir_step[][2] = {
+    [DIR_NONE] = {0, 0},
+    [DIR_UP] = {0, -1},
+    [DIR_DOWN] = {0, 1},
+    [DIR_LEFT] = {-1, 0},
+    [DIR_RIGHT] = {1, 0},
+};
+
+// Sprites a maze tile can carry. Every maze tile and sprite pair is
+// rendered once at startup, so an entity that moves only resends the two
+// tiles it left and entered, each as it will look.
+typedef enum {
+    SPRITE_NONE = 0,
+    SPRITE_PACMAN = 1,                            // + direction_t
+    SPRITE_GHOST = SPRITE_PACMAN + DIR_RIGHT + 1, // + ghost index
+    SPRITE_FRIGHTENED = SPRITE_GHOST + 4,
+    SPRITE_FLASH,                                 // Frightened, running out
+    SPRITE_KINDS
+} tile_sprite_t;
+
+#define TILE_KINDS  (TILE_POWER + 1)
+#define TILE_ID(tile, sprite)  ((sprite) * TILE_KINDS + (tile))
+
+static const lcd_sprite_t *const tile_sprites[SPRITE_KINDS] = {
+    [SPRITE_PACMAN + DIR_NONE] = &sprite_pacman_none,
+    [SPRITE_PACMAN + DIR_UP] = &sprite_pacman_up,
+    [SPRITE_PACMAN + DIR_DOWN] = &sprite_pacman_down,
+    [SPRITE_PACMAN + DIR_LEFT] = &sprite_pacman_left,
+    [SPRITE_PACMAN + DIR_RIGHT] = &sprite_pacman_right,
+    [SPRITE_GHOST + 0] = &sprite_ghost_red,
+    [SPRITE_GHOST + 1] = &sprite_ghost_pink,
+    [SPRITE_GHOST + 2] = &sprite_ghost_cyan,
+    [SPRITE_GHOST + 3] = &sprite_ghost_orange,
+    [SPRITE_FRIGHTENED] = &sprite_ghost_blue,
+    [SPRITE_FLASH] = &sprite_ghost_white,
+};
+
+// An entity's tile and sprite, as placed on the map
+typedef struct {
+    int x, y;
+    uint8_t sprite;
+} placed_t;
+
+// What the tile map holds: maze contents and where each entity was put
+static uint8_t drawn_maze[MAZE_HEIGHT][MAZE_WIDTH];
+static placed_t drawn_entities[5];
+static int drawn_entity_count;
+
+// Buttons pressed since the last input step
+static ebadge_input_frame_t buttons;
 
 // Forward declarations
 static void init_buttons(void);
-static bool read_button(int gpio_num, int btn_idx);
 static void init_entities(void);
 static void update_pacman(void);
 static void update_ghosts(void);
 static void check_collisions(void);
-static void draw_maze(void);
-static void draw_entity(entity_t *entity, bool is_pacman);
+static void draw_tile(void *arg);
+static void sync_maze(bool flash);
 static void draw_ui(void);
-static int tile_to_screen_x(int tx);
-static int tile_to_screen_y(int ty);
+static void render_scene(void *arg);
+static void invalidate_changes(void);
 static bool can_move(int tx, int ty);
 static direction_t get_opposite_dir(direction_t dir);
+static ghost_mode_t scheduled_mode(void);
 
 esp_err_t pacman_init(void) {
     ESP_LOGI(TAG, "Initializing Pac-Man game");
@@ -69,40 +134,45 @@ esp_err_t pacman_init(void) {
     // Initialize buttons
     init_buttons();
     
+    // Frames are composed off-screen and only changed bands are sent
+    lcd_set_renderer(render_scene, NULL);
+    
+    // The maze and everything moving through it is tiles: an eaten dot or a
+    // step resends single 12x12 tiles, with the sprites already composed
+    ESP_ERROR_CHECK(lcd_tilemap_init(&maze_map, GAME_OFFSET_X, GAME_OFFSET_Y,
+                                     MAZE_WIDTH, MAZE_HEIGHT, TILE_KINDS * SPRITE_KINDS));
+    for (int id = 0; id < TILE_KINDS * SPRITE_KINDS; id++) {
+        lcd_tilemap_define(&maze_map, id, draw_tile, (void *)(uintptr_t)id);
+    }
+    memset(drawn_maze, 0xFF, sizeof(drawn_maze));
+    
+    // The status bar is resent whenever the score moves; with a shadow only
+    // the digits that changed go out
+    ESP_ERROR_CHECK(lcd_set_shadow(0, 0, SCREEN_WIDTH, GAME_OFFSET_Y));
+    
     // Reset game state
     pacman_reset_game();
     
+    // Initial render: repaint everything on the first flush
+    lcd_invalidate(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    
     ESP_LOGI(TAG, "Game initialized successfully");
     return ESP_OK;
 }
 
 static void init_buttons(void) {
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL<<BTN_UP) | (1ULL<<BTN_DOWN) | 
-                        (1ULL<<BTN_LEFT) | (1ULL<<BTN_RIGHT) |
-                        (1ULL<<BTN_A) | (1ULL<<BTN_B),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
+    // Edges are caught by interrupt and queued for the next input step
+    const ebadge_input_config_t config = {
+        .gpio = {
+            [EBADGE_BUTTON_UP] = BTN_UP,
+            [EBADGE_BUTTON_DOWN] = BTN_DOWN,
+            [EBADGE_BUTTON_LEFT] = BTN_LEFT,
+            [EBADGE_BUTTON_RIGHT] = BTN_RIGHT,
+            [EBADGE_BUTTON_A] = BTN_A,
+            [EBADGE_BUTTON_B] = BTN_B,
+        },
     };
-    gpio_config(&io_conf);
-}
-
-static bool read_button(int gpio_num, int btn_idx) {
-    uint32_t now = esp_timer_get_time() / 1000;  // ms
-    if (gpio_get_level(gpio_num) == 0) {  // Active low
-        if (!button_pressed[btn_idx]) {
-            if (now - button_last_press[btn_idx] > BUTTON_DEBOUNCE_MS) {
-                button_pressed[btn_idx] = true;
-                button_last_press[btn_idx] = now;
-                return true;
-            }
-        }
-    } else {
-        button_pressed[btn_idx] = false;
-    }
-    return false;
+    ESP_ERROR_CHECK(ebadge_input_init(&config));
 }
 
 void pacman_reset_game(void) {
@@ -110,6 +180,7 @@ void pacman_reset_game(void) {
     
     // Copy maze
     memcpy(game.maze, initial_maze, sizeof(game.maze));
+    ESP_ERROR_CHECK(pacman_nav_build(game.maze));
     
     // Count dots
     game.dots_remaining = 0;
@@ -126,17 +197,13 @@ void pacman_reset_game(void) {
     game.lives = 3;
     game.game_over = false;
     game.paused = false;
+    game.exiting = false;
     game.power_timer = 0;
     game.game_tick = 0;
     game.level = 1;
     
     // Initialize entities
     init_entities();
-    
-    // Initial render
-    lcd_fill_screen(COLOR_BLACK);
-    draw_maze();
-    draw_ui();
 }
 
 static void init_entities(void) {
@@ -165,6 +232,7 @@ static void init_entities(void) {
     }
 }
 
+// Runs on the render task, which owns the display
 static void return_to_launcher(void) {
     ESP_LOGI(TAG, "Returning to launcher...");
     
@@ -193,32 +261,39 @@ static void return_to_launcher(void) {
 }
 
 void pacman_handle_input(void) {
+    ebadge_input_frame(&buttons);
+    if (game.exiting) return;
+    
     if (game.game_over || game.paused) {
         // Button B returns to launcher
-        if (read_button(BTN_B, 5)) {
-            return_to_launcher();
+        if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_B)) {
+            game.exiting = true;
+        }
+        // Button UP - frame profiler overlay
+        if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_UP)) {
+            game_profile_toggle_overlay();
         }
         return;
     }
     
     // Check pause
-    if (read_button(BTN_A, 4)) {
+    if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_A)) {
         game.paused = !game.paused;
         ESP_LOGI(TAG, "Pause toggled: %d", game.paused);
         return;
     }
     
     // D-pad controls - set next direction
-    if (read_button(BTN_UP, 0)) {
+    if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_UP)) {
         game.pacman.next_dir = DIR_UP;
     }
-    else if (read_button(BTN_DOWN, 1)) {
+    else if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_DOWN)) {
         game.pacman.next_dir = DIR_DOWN;
     }
-    else if (read_button(BTN_LEFT, 2)) {
+    else if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_LEFT)) {
         game.pacman.next_dir = DIR_LEFT;
     }
-    else if (read_button(BTN_RIGHT, 3)) {
+    else if (ebadge_input_pressed(&buttons, EBADGE_BUTTON_RIGHT)) {
         game.pacman.next_dir = DIR_RIGHT;
     }
 }
@@ -236,7 +311,7 @@ void pacman_update(void) {
             uint16_t ghost_colors[] = {COLOR_RED, COLOR_PINK, COLOR_CYAN, COLOR_ORANGE};
             for (int i = 0; i < 4; i++) {
                 if (game.ghosts[i].mode == GHOST_FRIGHTENED) {
-                    game.ghosts[i].mode = GHOST_CHASE;
+                    game.ghosts[i].mode = scheduled_mode();
                     game.ghosts[i].color = ghost_colors[i];
                 }
             }
@@ -317,90 +392,75 @@ static void update_pacman(void) {
     }
 }
 
+static ghost_mode_t scheduled_mode(void) {
+    return (game.game_tick % (SCATTER_TICKS + CHASE_TICKS) < SCATTER_TICKS) ? GHOST_SCATTER : GHOST_CHASE;
+}
+
 static void update_ghosts(void) {
+    int px = (int)roundf(game.pacman.x);
+    int py = (int)roundf(game.pacman.y);
+    
     for (int i = 0; i < 4; i++) {
-        if (!game.ghosts[i].active) continue;
+        entity_t *ghost = &game.ghosts[i];
+        if (!ghost->active) continue;
         
-        game.ghosts[i].move_timer++;
+        ghost->move_timer++;
         
         // Ghosts move slower (every 10 ticks)
-        int move_delay = (game.ghosts[i].mode == GHOST_FRIGHTENED) ? 12 : 10;
-        if (game.ghosts[i].move_timer < move_delay) continue;
-        game.ghosts[i].move_timer = 0;
-        
-        // Simple AI: try to move toward Pac-Man
-        int gx = (int)roundf(game.ghosts[i].x);
-        int gy = (int)roundf(game.ghosts[i].y);
-        int px = (int)roundf(game.pacman.x);
-        int py = (int)roundf(game.pacman.y);
-        
-        direction_t possible_dirs[4];
-        int possible_count = 0;
+        int move_delay = (ghost->mode == GHOST_FRIGHTENED) ? 12 : 10;
+        if (ghost->move_timer < move_delay) continue;
+        ghost->move_timer = 0;
         
-        // If frightened, move away from Pac-Man
-        bool flee = (game.ghosts[i].mode == GHOST_FRIGHTENED);
-        
-        // Check all directions
-        if (can_move(gx, gy - 1) && game.ghosts[i].dir != DIR_DOWN) {
-            possible_dirs[possible_count++] = DIR_UP;
-        }
-        if (can_move(gx, gy + 1) && game.ghosts[i].dir != DIR_UP) {
-            possible_dirs[possible_count++] = DIR_DOWN;
+        // Chasing ghosts head for Pac-Man, scattering ones for their corner,
+        // and frightened ones away from Pac-Man
+        if (ghost->mode != GHOST_FRIGHTENED) {
+            ghost->mode = scheduled_mode();
         }
-        if (can_move(gx - 1, gy) && game.ghosts[i].dir != DIR_RIGHT) {
-            possible_dirs[possible_count++] = DIR_LEFT;
-        }
-        if (can_move(gx + 1, gy) && game.ghosts[i].dir != DIR_LEFT) {
-            possible_dirs[possible_count++] = DIR_RIGHT;
+        bool flee = (ghost->mode == GHOST_FRIGHTENED);
+        if (ghost->mode == GHOST_SCATTER) {
+            ghost->target_x = scatter_corner[i][0];
+            ghost->target_y = scatter_corner[i][1];
+        } else {
+            ghost->target_x = px;
+            ghost->target_y = py;
         }
         
-        // Choose best direction
-        if (possible_count > 0) {
-            direction_t best_dir = possible_dirs[0];
-            float best_dist = 999999.0f;
+        // Every open neighbor but the way back, rated by walking distance
+        // to the target: one table lookup each. A dead end is the only
+        // place a ghost turns around.
+        int gx = (int)roundf(ghost->x);
+        int gy = (int)roundf(ghost->y);
+        direction_t back = get_opposite_dir(ghost->dir);
+        direction_t best_dir = DIR_NONE;
+        int best_rating = -1;
+        
+        for (direction_t d = DIR_UP; d <= DIR_RIGHT; d++) {
+            int nx = gx + dir_step[d][0];
+            int ny = gy + dir_step[d][1];
+            if (d == back || !can_move(nx, ny)) continue;
             
-            for (int d = 0; d < possible_count; d++) {
-                int test_x = gx, test_y = gy;
-                switch (possible_dirs[d]) {
-                    case DIR_UP: test_y--; break;
-                    case DIR_DOWN: test_y++; break;
-                    case DIR_LEFT: test_x--; break;
-                    case DIR_RIGHT: test_x++; break;
-                    default: break;
-                }
-                
-                float dist = sqrtf((test_x - px) * (test_x - px) + (test_y - py) * (test_y - py));
-                
-                if (flee) {
-                    // Flee: maximize distance
-                    if (dist > best_dist) {
-                        best_dist = dist;
-                        best_dir = possible_dirs[d];
-                    }
-                } else {
-                    // Chase: minimize distance
-                    if (dist < best_dist) {
-                        best_dist = dist;
-                        best_dir = possible_dirs[d];
-                    }
-                }
+            int dist = pacman_nav_distance(nx, ny, ghost->target_x, ghost->target_y);
+            int rating = flee ? dist : NAV_UNREACHABLE - dist;
+            if (rating > best_rating) {
+                best_rating = rating;
+                best_dir = d;
             }
-            
-            game.ghosts[i].dir = best_dir;
+        }
+        if (best_dir == DIR_NONE && back != DIR_NONE &&
+            can_move(gx + dir_step[back][0], gy + dir_step[back][1])) {
+            best_dir = back;
+        }
+        if (best_dir != DIR_NONE) {
+            ghost->dir = best_dir;
         }
         
         // Move ghost
-        switch (game.ghosts[i].dir) {
-            case DIR_UP: gy--; break;
-            case DIR_DOWN: gy++; break;
-            case DIR_LEFT: gx--; break;
-            case DIR_RIGHT: gx++; break;
-            default: break;
-        }
+        gx += dir_step[ghost->dir][0];
+        gy += dir_step[ghost->dir][1];
         
         if (can_move(gx, gy)) {
-            game.ghosts[i].x = gx;
-            game.ghosts[i].y = gy;
+            ghost->x = gx;
+            ghost->y = gy;
         }
     }
 }
@@ -440,117 +500,178 @@ static void check_collisions(void) {
     }
 }
 
-void pacman_render(void) {
-    // Only redraw changed parts for better performance
-    draw_maze();
+void pacman_snapshot(game_state_t *frame) {
+    *frame = game;
+}
+
+void pacman_render(const game_state_t *frame) {
+    if (frame->exiting) {
+        return_to_launcher();
+        return;
+    }
+    shown = frame;
     
-    // Draw Pac-Man
-    draw_entity(&game.pacman, true);
+    // Frightened ghosts flash white while power mode runs out
+    bool flash = frame->power_timer > 0 && frame->power_timer < 120 && (frame->power_timer / 15) % 2;
     
-    // Draw ghosts
-    for (int i = 0; i < 4; i++) {
-        if (game.ghosts[i].active) {
-            draw_entity(&game.ghosts[i], false);
-        }
+    // Changed tiles go straight to the panel unless an overlay covers them
+    sync_maze(flash);
+    if (frame->game_over || frame->paused) {
+        lcd_tilemap_invalidate(&maze_map);
+    } else {
+        lcd_tilemap_flush(&maze_map);
     }
     
+    // Only bands touched by something else that changed are redrawn
+    invalidate_changes();
+    lcd_flush();
+}
+
+// Full scene, recorded by lcd_flush once per frame
+static void render_scene(void *arg) {
+    // Maze with Pac-Man and the ghosts in it
+    lcd_tilemap_draw(&maze_map);
+    
     draw_ui();
+    game_profile_draw_overlay();
 }
 
-static void draw_maze(void) {
-    for (int y = 0; y < MAZE_HEIGHT; y++) {
-        for (int x = 0; x < MAZE_WIDTH; x++) {
-            int sx = tile_to_screen_x(x);
-            int sy = tile_to_screen_y(y);
-            
-            uint8_t tile = game.maze[y][x];
-            
-            switch (tile) {
-                case TILE_WALL:
-                    lcd_fill_rect(sx, sy, TILE_SIZE, TILE_SIZE, COLOR_WALL);
-                    break;
-                case TILE_DOT:
-                    lcd_fill_rect(sx, sy, TILE_SIZE, TILE_SIZE, COLOR_BLACK);
-                    lcd_fill_circle(sx + TILE_SIZE/2, sy + TILE_SIZE/2, 2, COLOR_WHITE);
-                    break;
-                case TILE_POWER:
-                    lcd_fill_rect(sx, sy, TILE_SIZE, TILE_SIZE, COLOR_BLACK);
-                    lcd_fill_circle(sx + TILE_SIZE/2, sy + TILE_SIZE/2, 4, COLOR_WHITE);
-                    break;
-                case TILE_EMPTY:
-                    lcd_fill_rect(sx, sy, TILE_SIZE, TILE_SIZE, COLOR_BLACK);
-                    break;
-            }
+// Mark the screen areas whose contents changed since the last frame
+static void invalidate_changes(void) {
+    static uint32_t drawn_score;
+    static uint8_t drawn_lives;
+    static uint32_t drawn_level;
+    static bool drawn_game_over, drawn_paused;
+    
+    if (drawn_score != shown->score || drawn_lives != shown->lives || drawn_level != shown->level) {
+        lcd_invalidate(0, 0, SCREEN_WIDTH, GAME_OFFSET_Y);
+        drawn_score = shown->score;
+        drawn_lives = shown->lives;
+        drawn_level = shown->level;
+    }
+    if (drawn_game_over != shown->game_over || drawn_paused != shown->paused) {
+        lcd_invalidate(40, SCREEN_HEIGHT/2 - 30, 160, 65);
+        drawn_game_over = shown->game_over;
+        drawn_paused = shown->paused;
+    }
+}
+
+// Tile image for a TILE_ID, in tile-local coordinates
+static void draw_tile(void *arg) {
+    uint8_t id = (uintptr_t)arg;
+    switch (id % TILE_KINDS) {
+        case TILE_WALL:
+            lcd_fill_rect(0, 0, TILE_SIZE, TILE_SIZE, COLOR_WALL);
+            break;
+        case TILE_DOT:
+            lcd_fill_circle(TILE_SIZE/2, TILE_SIZE/2, 2, COLOR_WHITE);
+            break;
+        case TILE_POWER:
+            lcd_fill_circle(TILE_SIZE/2, TILE_SIZE/2, 4, COLOR_WHITE);
+            break;
+        case TILE_EMPTY:
+            break;
+    }
+    
+    // Corners are transparent; the circle covers any dot on the tile
+    const lcd_sprite_t *sprite = tile_sprites[id / TILE_KINDS];
+    if (sprite != NULL) {
+        lcd_draw_sprite(0, 0, sprite);
+    }
+}
+
+// Where each entity goes, in drawing order: later ones cover earlier ones
+// on a shared tile
+static int place_entities(const game_state_t *frame, bool flash, placed_t *out) {
+    int n = 0;
+    out[n++] = (placed_t){
+        .x = (int)roundf(frame->pacman.x),
+        .y = (int)roundf(frame->pacman.y),
+        .sprite = SPRITE_PACMAN + frame->pacman.dir,
+    };
+    for (int i = 0; i < 4; i++) {
+        const entity_t *ghost = &frame->ghosts[i];
+        if (!ghost->active) continue;
+        uint8_t sprite = SPRITE_GHOST + i;
+        if (ghost->color == COLOR_BLUE) {
+            sprite = flash ? SPRITE_FLASH : SPRITE_FRIGHTENED;
         }
+        out[n++] = (placed_t){
+            .x = (int)roundf(ghost->x),
+            .y = (int)roundf(ghost->y),
+            .sprite = sprite,
+        };
     }
+    return n;
 }
 
-static void draw_entity(entity_t *entity, bool is_pacman) {
-    int sx = tile_to_screen_x((int)roundf(entity->x));
-    int sy = tile_to_screen_y((int)roundf(entity->y));
-    
-    // Clear old position (draw maze tile)
-    lcd_fill_rect(sx, sy, TILE_SIZE, TILE_SIZE, COLOR_BLACK);
-    
-    // Draw entity
-    int radius = TILE_SIZE / 2 - 1;
-    lcd_fill_circle(sx + radius + 1, sy + radius + 1, radius, entity->color);
-    
-    if (is_pacman) {
-        // Draw mouth
-        int mx = sx + radius + 1;
-        int my = sy + radius + 1;
-        switch (entity->dir) {
-            case DIR_RIGHT:
-                lcd_draw_pixel(mx + radius - 1, my, COLOR_BLACK);
-                lcd_draw_pixel(mx + radius - 2, my - 1, COLOR_BLACK);
-                lcd_draw_pixel(mx + radius - 2, my + 1, COLOR_BLACK);
-                break;
-            case DIR_LEFT:
-                lcd_draw_pixel(mx - radius + 1, my, COLOR_BLACK);
-                lcd_draw_pixel(mx - radius + 2, my - 1, COLOR_BLACK);
-                lcd_draw_pixel(mx - radius + 2, my + 1, COLOR_BLACK);
-                break;
-            case DIR_UP:
-                lcd_draw_pixel(mx, my - radius + 1, COLOR_BLACK);
-                lcd_draw_pixel(mx - 1, my - radius + 2, COLOR_BLACK);
-                lcd_draw_pixel(mx + 1, my - radius + 2, COLOR_BLACK);
-                break;
-            case DIR_DOWN:
-                lcd_draw_pixel(mx, my + radius - 1, COLOR_BLACK);
-                lcd_draw_pixel(mx - 1, my + radius - 2, COLOR_BLACK);
-                lcd_draw_pixel(mx + 1, my + radius - 2, COLOR_BLACK);
-                break;
-            default:
-                break;
+// Tile id at (x, y): the maze tile and the topmost entity on it
+static uint8_t tile_id(const placed_t *placed, int count, int x, int y) {
+    uint8_t sprite = SPRITE_NONE;
+    for (int i = 0; i < count; i++) {
+        if (placed[i].x == x && placed[i].y == y) {
+            sprite = placed[i].sprite;
         }
     }
+    return TILE_ID(shown->maze[y][x], sprite);
+}
+
+static void sync_tile(const placed_t *placed, int count, int x, int y) {
+    if (x >= 0 && x < MAZE_WIDTH && y >= 0 && y < MAZE_HEIGHT) {
+        lcd_tilemap_set(&maze_map, x, y, tile_id(placed, count, x, y));
+    }
+}
+
+// Update only the tiles that can have changed: maze rows that differ from
+// what is drawn (an eaten dot, a new level), and the tiles the entities
+// left and entered. The tile map marks a tile dirty only if its id moved.
+static void sync_maze(bool flash) {
+    placed_t placed[5];
+    int count = place_entities(shown, flash, placed);
+    
+    for (int y = 0; y < MAZE_HEIGHT; y++) {
+        if (memcmp(drawn_maze[y], shown->maze[y], MAZE_WIDTH) != 0) {
+            for (int x = 0; x < MAZE_WIDTH; x++) {
+                sync_tile(placed, count, x, y);
+            }
+            memcpy(drawn_maze[y], shown->maze[y], MAZE_WIDTH);
+        }
+    }
+    
+    for (int i = 0; i < drawn_entity_count; i++) {
+        sync_tile(placed, count, drawn_entities[i].x, drawn_entities[i].y);
+    }
+    for (int i = 0; i < count; i++) {
+        sync_tile(placed, count, placed[i].x, placed[i].y);
+    }
+    memcpy(drawn_entities, placed, sizeof(placed));
+    drawn_entity_count = count;
 }
 
 static void draw_ui(void) {
     // Draw score
     char buf[32];
-    snprintf(buf, sizeof(buf), "SCORE:%lu", (unsigned long)game.score);
+    snprintf(buf, sizeof(buf), "SCORE:%lu", (unsigned long)shown->score);
     lcd_draw_string(10, 10, buf, COLOR_WHITE, COLOR_BLACK);
     
     // Draw lives
-    snprintf(buf, sizeof(buf), "LIVES:%d", game.lives);
+    snprintf(buf, sizeof(buf), "LIVES:%d", shown->lives);
     lcd_draw_string(10, 25, buf, COLOR_WHITE, COLOR_BLACK);
     
     // Draw level
-    snprintf(buf, sizeof(buf), "LVL:%lu", (unsigned long)game.level);
+    snprintf(buf, sizeof(buf), "LVL:%lu", (unsigned long)shown->level);
     lcd_draw_string(160, 10, buf, COLOR_WHITE, COLOR_BLACK);
     
     // Draw status
-    if (game.game_over) {
+    if (shown->game_over) {
         lcd_fill_rect(40, SCREEN_HEIGHT/2 - 30, 160, 65, COLOR_BLACK);
         lcd_draw_rect(40, SCREEN_HEIGHT/2 - 30, 160, 65, COLOR_RED);
         lcd_draw_string(60, SCREEN_HEIGHT/2 - 20, "GAME OVER", COLOR_RED, COLOR_BLACK);
-        snprintf(buf, sizeof(buf), "SCORE:%lu", (unsigned long)game.score);
+        snprintf(buf, sizeof(buf), "SCORE:%lu", (unsigned long)shown->score);
         lcd_draw_string(60, SCREEN_HEIGHT/2 - 5, buf, COLOR_WHITE, COLOR_BLACK);
         lcd_draw_string(45, SCREEN_HEIGHT/2 + 10, "Press B to", COLOR_WHITE, COLOR_BLACK);
         lcd_draw_string(40, SCREEN_HEIGHT/2 + 25, "return to menu", COLOR_WHITE, COLOR_BLACK);
-    } else if (game.paused) {
+    } else if (shown->paused) {
         lcd_fill_rect(40, SCREEN_HEIGHT/2 - 30, 160, 60, COLOR_BLACK);
         lcd_draw_rect(40, SCREEN_HEIGHT/2 - 30, 160, 60, COLOR_YELLOW);
         lcd_draw_string(75, SCREEN_HEIGHT/2 - 20, "PAUSED", COLOR_YELLOW, COLOR_BLACK);
@@ -559,14 +680,6 @@ static void draw_ui(void) {
     }
 }
 
-static int tile_to_screen_x(int tx) {
-    return GAME_OFFSET_X + tx * TILE_SIZE;
-}
-
-static int tile_to_screen_y(int ty) {
-    return GAME_OFFSET_Y + ty * TILE_SIZE;
-}
-
 static bool can_move(int tx, int ty) {
     if (tx < 0 || tx >= MAZE_WIDTH || ty < 0 || ty >= MAZE_HEIGHT) {
         return false;
@@ -584,8 +697,31 @@ static direction_t get_opposite_dir(direction_t dir) {
     }
 }
 
-void pacman_game_loop(void) {
+// Logic task: input and one fixed step of simulation
+static void input_step(void *arg) {
     pacman_handle_input();
+}
+
+static void update_step(float dt, void *arg) {
     pacman_update();
-    pacman_render();
+}
+
+static void snapshot_frame(void *frame, void *arg) {
+    pacman_snapshot(frame);
+}
+
+static void render_frame(const void *frame, void *arg) {
+    pacman_render(frame);
+}
+
+esp_err_t pacman_start(void) {
+    game_tasks_config_t config = {
+        .input = input_step,
+        .update = update_step,
+        .snapshot = snapshot_frame,
+        .render = render_frame,
+        .frame_size = sizeof(game_state_t),
+        .tick_hz = 60,
+    };
+    return game_tasks_start(&config);
 }
@@ -101,6 +101,7 @@ typedef struct {
     uint16_t dots_remaining;
     bool game_over;
     bool paused;
+    bool exiting;            // B pressed to leave; the renderer restarts
     uint32_t power_timer;
     uint32_t game_tick;
     uint32_t level;
@@ -115,9 +116,10 @@ typedef struct {
 esp_err_t pacman_init(void);
 
 /**
- * @brief Main game loop (call repeatedly)
+ * @brief Start the logic and render tasks (returns once they run)
+ * @return ESP_OK on success
  */
-void pacman_game_loop(void);
+esp_err_t pacman_start(void);
 
 /**
  * @brief Reset game to initial state
@@ -135,8 +137,14 @@ void pacman_handle_input(void);
 void pacman_update(void);
 
 /**
- * @brief Render the game
+ * @brief Copy the game state for the renderer. The whole state is small, so
+ * the snapshot the logic task publishes (see game_tasks.h) is a plain copy.
+ */
+void pacman_snapshot(game_state_t *frame);
+
+/**
+ * @brief Render a snapshot
  */
-void pacman_render(void);
+void pacman_render(const game_state_t *frame);
 
 #endif // PACMAN_GAME_H
@@ -8,6 +8,7 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
+#include "ebadge_trace.h"
 #include "pacman_game.h"
 
 static const char *TAG = "main";
@@ -23,14 +24,14 @@ void app_main(void) {
     }
     ESP_ERROR_CHECK(ret);
     
+    // Event trace, dumped by typing "trace" on the console
+    ESP_ERROR_CHECK(ebadge_trace_init());
+    
     // Initialize game
     ESP_ERROR_CHECK(pacman_init());
     
-    ESP_LOGI(TAG, "Game initialized, starting main loop");
+    ESP_LOGI(TAG, "Game initialized, starting game tasks");
     
-    // Main game loop
-    while (1) {
-        pacman_game_loop();
-        vTaskDelay(pdMS_TO_TICKS(16));  // ~60 FPS
-    }
+    // Logic and rendering run in their own tasks from here on
+    ESP_ERROR_CHECK(pacman_start());
 }
@@ -0,0 +1,117 @@
+/**
+ * @file pacman_nav.c
+ * @brief All-pairs maze distances by breadth-first search
+ */
+
+#include "pacman_nav.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "nav";
+
+#define NAV_WALL   0xFFFF
+#define NAV_TILES  (MAZE_WIDTH * MAZE_HEIGHT)
+
+// Open tiles are numbered in reading order; walls get no number
+static uint16_t cell_of[MAZE_HEIGHT][MAZE_WIDTH];
+static uint8_t cell_x[NAV_TILES], cell_y[NAV_TILES];
+static int cell_count;
+
+// distance[from * cell_count + to], in steps
+static uint8_t *distance;
+static size_t distance_size;
+
+static const int8_t nav_step[4][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+
+static bool in_maze(int x, int y) {
+    return x >= 0 && x < MAZE_WIDTH && y >= 0 && y < MAZE_HEIGHT;
+}
+
+esp_err_t pacman_nav_build(const uint8_t maze[MAZE_HEIGHT][MAZE_WIDTH]) {
+    cell_count = 0;
+    for (int y = 0; y < MAZE_HEIGHT; y++) {
+        for (int x = 0; x < MAZE_WIDTH; x++) {
+            if (maze[y][x] == TILE_WALL) {
+                cell_of[y][x] = NAV_WALL;
+                continue;
+            }
+            cell_of[y][x] = cell_count;
+            cell_x[cell_count] = x;
+            cell_y[cell_count] = y;
+            cell_count++;
+        }
+    }
+
+    // Every level has the same walls, so this is allocated once
+    size_t size = (size_t)cell_count * cell_count;
+    if (size > distance_size) {
+        heap_caps_free(distance);
+        distance = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+        if (distance == NULL) {
+            distance_size = 0;
+            cell_count = 0;
+            ESP_LOGE(TAG, "No memory for a %u byte distance table", (unsigned)size);
+            return ESP_ERR_NO_MEM;
+        }
+        distance_size = size;
+        ESP_LOGI(TAG, "%d open tiles, %u byte distance table", cell_count, (unsigned)size);
+    }
+    memset(distance, NAV_UNREACHABLE, size);
+
+    // One search per open tile. Paths longer than the byte allows stop
+    // growing at NAV_UNREACHABLE - 1; this maze's longest is far shorter.
+    uint16_t queue[NAV_TILES];
+    for (int from = 0; from < cell_count; from++) {
+        uint8_t *row = distance + (size_t)from * cell_count;
+        int head = 0, tail = 0;
+        row[from] = 0;
+        queue[tail++] = from;
+        while (head < tail) {
+            int c = queue[head++];
+            uint8_t next = (row[c] < NAV_UNREACHABLE - 1) ? row[c] + 1 : NAV_UNREACHABLE - 1;
+            for (int d = 0; d < 4; d++) {
+                int nx = cell_x[c] + nav_step[d][0];
+                int ny = cell_y[c] + nav_step[d][1];
+                if (!in_maze(nx, ny)) {
+                    continue;
+                }
+                uint16_t n = cell_of[ny][nx];
+                if (n != NAV_WALL && row[n] == NAV_UNREACHABLE) {
+                    row[n] = next;
+                    queue[tail++] = n;
+                }
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+uint8_t pacman_nav_distance(int from_x, int from_y, int to_x, int to_y) {
+    if (!in_maze(from_x, from_y) || !in_maze(to_x, to_y) || distance == NULL) {
+        return NAV_UNREACHABLE;
+    }
+    uint16_t from = cell_of[from_y][from_x];
+    uint16_t to = cell_of[to_y][to_x];
+    if (from == NAV_WALL) {
+        return NAV_UNREACHABLE;
+    }
+    if (to != NAV_WALL) {
+        return distance[(size_t)from * cell_count + to];
+    }
+
+    // Pac-Man starts inside a wall tile; go by the nearest open tile beside it
+    uint8_t best = NAV_UNREACHABLE;
+    for (int d = 0; d < 4; d++) {
+        int nx = to_x + nav_step[d][0];
+        int ny = to_y + nav_step[d][1];
+        if (in_maze(nx, ny) && cell_of[ny][nx] != NAV_WALL) {
+            uint8_t dist = distance[(size_t)from * cell_count + cell_of[ny][nx]];
+            if (dist < NAV_UNREACHABLE - 1 && dist + 1 < best) {
+                best = dist + 1;
+            }
+        }
+    }
+    return best;
+}
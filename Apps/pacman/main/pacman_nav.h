@@ -0,0 +1,31 @@
+/**
+ * @file pacman_nav.h
+ * @brief Maze distances for ghost pathing
+ *
+ * Built once per level from the maze walls: a breadth-first search from
+ * every open tile gives the shortest walking distance to every other, one
+ * byte each. A ghost picks its turn with one lookup per direction instead
+ * of measuring a straight line that ignores walls.
+ */
+
+#ifndef PACMAN_NAV_H
+#define PACMAN_NAV_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "pacman_game.h"
+
+#define NAV_UNREACHABLE  255  // No path, or either end is a wall
+
+/**
+ * @brief Rebuild the distance table for a maze (dots and pellets count as open)
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the table cannot be allocated
+ */
+esp_err_t pacman_nav_build(const uint8_t maze[MAZE_HEIGHT][MAZE_WIDTH]);
+
+/**
+ * @brief Steps along the maze between two tiles
+ */
+uint8_t pacman_nav_distance(int from_x, int from_y, int to_x, int to_y);
+
+#endif // PACMAN_NAV_H
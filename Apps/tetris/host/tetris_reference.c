@@ -0,0 +1,252 @@
+/**
+ * @file tetris_reference.c
+ * @brief The cell-by-cell Tetris engine the bitboard replaced
+ */
+
+#include "tetris_reference.h"
+#include <string.h>
+
+// One byte per shape cell, as the old table was; filled from the row masks
+// so the two engines cannot disagree about the shapes
+static uint8_t shape_cells[TETROMINO_COUNT][4][4][4];
+static bool shapes_ready;
+
+static void spawn_piece(reference_state_t *game, tetromino_t *piece);
+static bool check_collision(const reference_state_t *game, const tetromino_t *piece);
+static void lock_piece(reference_state_t *game);
+static void clear_lines(reference_state_t *game);
+static void move_piece(reference_state_t *game, int dx, int dy);
+static int get_drop_interval(const reference_state_t *game);
+
+void reference_reset(reference_state_t *game, uint32_t seed) {
+    if (!shapes_ready) {
+        for (int t = 0; t < TETROMINO_COUNT; t++) {
+            for (int r = 0; r < 4; r++) {
+                for (int y = 0; y < 4; y++) {
+                    for (int x = 0; x < 4; x++) {
+                        shape_cells[t][r][y][x] = (tetromino_shapes[t][r][y] >> x) & 1;
+                    }
+                }
+            }
+        }
+        shapes_ready = true;
+    }
+
+    memset(game->board, 0, sizeof(game->board));
+    game->score = 0;
+    game->lines_cleared = 0;
+    game->level = 1;
+    game->pieces = 0;
+    game->game_over = false;
+    game->paused = false;
+    game->exiting = false;
+    game->drop_timer = 0;
+    game->drop_interval = get_drop_interval(game);
+    game->game_tick = 0;
+    game->rng = seed ? seed : 1;
+
+    spawn_piece(game, &game->current_piece);
+    spawn_piece(game, &game->next_piece);
+}
+
+// Same generator as tetris_logic.c, so a seed deals the same pieces
+static uint32_t next_random(reference_state_t *game) {
+    uint32_t x = game->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    game->rng = x;
+    return x;
+}
+
+static void spawn_piece(reference_state_t *game, tetromino_t *piece) {
+    piece->type = next_random(game) % TETROMINO_COUNT;
+    piece->x = BOARD_WIDTH / 2 - 2;
+    piece->y = 0;
+    piece->rotation = 0;
+}
+
+static bool check_collision(const reference_state_t *game, const tetromino_t *piece) {
+    const uint8_t (*shape)[4] = shape_cells[piece->type][piece->rotation];
+
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            if (shape[y][x]) {
+                int board_x = piece->x + x;
+                int board_y = piece->y + y;
+
+                if (board_x < 0 || board_x >= BOARD_WIDTH ||
+                    board_y < 0 || board_y >= BOARD_HEIGHT) {
+                    return true;
+                }
+                if (game->board[board_y][board_x] != 0) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+static void lock_piece(reference_state_t *game) {
+    const tetromino_t *piece = &game->current_piece;
+    const uint8_t (*shape)[4] = shape_cells[piece->type][piece->rotation];
+
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            if (shape[y][x]) {
+                int board_x = piece->x + x;
+                int board_y = piece->y + y;
+                if (board_y >= 0 && board_y < BOARD_HEIGHT &&
+                    board_x >= 0 && board_x < BOARD_WIDTH) {
+                    game->board[board_y][board_x] = piece->type + 1;
+                }
+            }
+        }
+    }
+    game->pieces++;
+
+    clear_lines(game);
+
+    game->current_piece = game->next_piece;
+    spawn_piece(game, &game->next_piece);
+
+    if (check_collision(game, &game->current_piece)) {
+        game->game_over = true;
+    }
+}
+
+static void clear_lines(reference_state_t *game) {
+    int lines_cleared_now = 0;
+
+    // Check each row from bottom to top
+    for (int y = BOARD_HEIGHT - 1; y >= 0; y--) {
+        bool full = true;
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            if (game->board[y][x] == 0) {
+                full = false;
+                break;
+            }
+        }
+
+        if (full) {
+            lines_cleared_now++;
+
+            // Move all rows above down
+            for (int yy = y; yy > 0; yy--) {
+                for (int x = 0; x < BOARD_WIDTH; x++) {
+                    game->board[yy][x] = game->board[yy - 1][x];
+                }
+            }
+            for (int x = 0; x < BOARD_WIDTH; x++) {
+                game->board[0][x] = 0;
+            }
+
+            y++;  // Check this row again
+        }
+    }
+
+    if (lines_cleared_now > 0) {
+        static const uint32_t line_scores[] = {0, 100, 300, 500, 800};
+        game->score += line_scores[lines_cleared_now] * game->level;
+        game->lines_cleared += lines_cleared_now;
+        game->level = game->lines_cleared / 10 + 1;
+        game->drop_interval = get_drop_interval(game);
+    }
+}
+
+static void rotate_piece(reference_state_t *game) {
+    tetromino_t test_piece = game->current_piece;
+    test_piece.rotation = (test_piece.rotation + 1) % 4;
+
+    if (!check_collision(game, &test_piece)) {
+        game->current_piece.rotation = test_piece.rotation;
+    }
+}
+
+static void move_piece(reference_state_t *game, int dx, int dy) {
+    tetromino_t test_piece = game->current_piece;
+    test_piece.x += dx;
+    test_piece.y += dy;
+
+    if (!check_collision(game, &test_piece)) {
+        game->current_piece.x = test_piece.x;
+        game->current_piece.y = test_piece.y;
+    } else if (dy > 0) {
+        lock_piece(game);
+        game->drop_timer = 0;
+    }
+}
+
+static void hard_drop(reference_state_t *game) {
+    while (true) {
+        tetromino_t test_piece = game->current_piece;
+        test_piece.y++;
+
+        if (check_collision(game, &test_piece)) {
+            lock_piece(game);
+            game->drop_timer = 0;
+            game->score += 2;
+            break;
+        }
+        game->current_piece.y++;
+    }
+}
+
+static int get_drop_interval(const reference_state_t *game) {
+    int interval = 60 - (int)(game->level - 1) * 5;
+    return (interval < 10) ? 10 : interval;
+}
+
+void reference_input(reference_state_t *game, uint8_t keys) {
+    if (game->exiting) return;
+
+    if (game->game_over) {
+        if (keys & TETRIS_KEY_BACK) {
+            game->exiting = true;
+        }
+        return;
+    }
+
+    if (game->paused) {
+        if (keys & TETRIS_KEY_HARD_DROP) {
+            game->paused = false;
+        }
+        if (keys & TETRIS_KEY_BACK) {
+            game->exiting = true;
+        }
+        return;
+    }
+
+    if (keys & TETRIS_KEY_ROTATE) {
+        rotate_piece(game);
+    }
+    if (keys & TETRIS_KEY_LEFT) {
+        move_piece(game, -1, 0);
+    }
+    if (keys & TETRIS_KEY_RIGHT) {
+        move_piece(game, 1, 0);
+    }
+    if (keys & TETRIS_KEY_SOFT_DROP) {
+        move_piece(game, 0, 1);
+        game->score += 1;
+    }
+    if (keys & TETRIS_KEY_HARD_DROP) {
+        hard_drop(game);
+    }
+    if (keys & TETRIS_KEY_BACK) {
+        game->paused = true;
+    }
+}
+
+void reference_update(reference_state_t *game) {
+    if (game->game_over || game->paused) return;
+
+    game->game_tick++;
+    game->drop_timer++;
+
+    if (game->drop_timer >= game->drop_interval) {
+        move_piece(game, 0, 1);
+        game->drop_timer = 0;
+    }
+}
@@ -0,0 +1,38 @@
+/**
+ * @file tetris_reference.h
+ * @brief The cell-by-cell Tetris engine the bitboard replaced, for comparison
+ *
+ * Same rules, piece generator and key handling as tetris_logic.h, kept the
+ * way tetris_game.c had them before the playfield became row masks: one
+ * byte per cell, a bounds check and a board read for every shape cell in a
+ * collision test, and rows shifted down one cleared line at a time. Host
+ * only; tetris_sim -b replays a script through both and times them.
+ */
+
+#ifndef TETRIS_REFERENCE_H
+#define TETRIS_REFERENCE_H
+
+#include "tetris_logic.h"
+
+typedef struct {
+    uint8_t board[BOARD_HEIGHT][BOARD_WIDTH];  // 0=empty, 1-7=color
+    tetromino_t current_piece;
+    tetromino_t next_piece;
+    uint32_t score;
+    uint32_t lines_cleared;
+    uint32_t level;
+    uint32_t pieces;
+    bool game_over;
+    bool paused;
+    bool exiting;
+    uint32_t drop_timer;
+    uint32_t drop_interval;
+    uint32_t game_tick;
+    uint32_t rng;
+} reference_state_t;
+
+void reference_reset(reference_state_t *game, uint32_t seed);
+void reference_input(reference_state_t *game, uint8_t keys);
+void reference_update(reference_state_t *game);
+
+#endif // TETRIS_REFERENCE_H
@@ -0,0 +1,559 @@
+/**
+ * @file tetris_sim.c
+ * @brief Headless Tetris: a greedy bot plays the real rules on the host
+ *
+ * The bot tries every rotation and column for each piece on a copy of the
+ * game, keeps the placement with the best board and then plays it with
+ * the same key presses the buttons would give. Every step is checked
+ * against a plain cell-by-cell model of the rules, then the recorded keys
+ * are replayed with nothing else running to time the engine.
+ *
+ *   tetris_sim [-s seed] [-n pieces] [-w script] [-b] [-q]
+ *   tetris_sim -r script [-b] [-q]
+ *
+ * A script has one line per 60 Hz step: the buttons pressed in that step
+ * (U D L R A B, or . for none), optionally followed by "xN" to repeat it.
+ * "seed N" starts a new game. -w writes the bot's games in this form.
+ *
+ * The printed checksum covers the end of every game, so a change to the
+ * engine that is meant to be invisible must leave it as it was.
+ *
+ * -b also replays the games through the cell-by-cell engine the bitboard
+ * replaced (tetris_reference.c), checks that every game ends the same way
+ * in both, and times the two on the same keys.
+ */
+
+#include "tetris_logic.h"
+#include "tetris_reference.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SIM_MIN_TIMED_NS  200000000LL  // Replay until at least this long
+#define SIM_MAX_PLAN      16           // Steps to place one piece
+
+// Same buttons as the badge (see button_keys in tetris_game.c)
+static const struct {
+    char name;
+    uint8_t key;
+} buttons[] = {
+    {'U', TETRIS_KEY_ROTATE},
+    {'D', TETRIS_KEY_SOFT_DROP},
+    {'L', TETRIS_KEY_LEFT},
+    {'R', TETRIS_KEY_RIGHT},
+    {'A', TETRIS_KEY_HARD_DROP},
+    {'B', TETRIS_KEY_BACK},
+};
+#define BUTTON_COUNT (sizeof(buttons) / sizeof(buttons[0]))
+
+// Recorded games: the keys of each step, and where each game starts
+typedef struct {
+    uint32_t seed;
+    size_t first, count;
+} game_span_t;
+
+static uint8_t *steps;
+static size_t step_count, step_cap;
+static game_span_t *games;
+static size_t game_count, game_cap;
+
+static bool quiet;
+
+static void record_game(uint32_t seed) {
+    if (game_count == game_cap) {
+        game_cap = game_cap ? game_cap * 2 : 16;
+        games = realloc(games, game_cap * sizeof(*games));
+    }
+    games[game_count++] = (game_span_t){.seed = seed, .first = step_count};
+}
+
+static void record_step(uint8_t keys) {
+    if (step_count == step_cap) {
+        step_cap = step_cap ? step_cap * 2 : 4096;
+        steps = realloc(steps, step_cap);
+    }
+    steps[step_count++] = keys;
+    games[game_count - 1].count++;
+}
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// FNV-1a over what a game produced
+static uint32_t hash_bytes(uint32_t h, const void *data, size_t len) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t hash_state(uint32_t h, const tetris_state_t *g) {
+    h = hash_bytes(h, g->rows, sizeof(g->rows));
+    h = hash_bytes(h, g->board, sizeof(g->board));
+    h = hash_bytes(h, &g->current_piece, sizeof(g->current_piece));
+    h = hash_bytes(h, &g->next_piece, sizeof(g->next_piece));
+    uint32_t counters[] = {g->score, g->lines_cleared, g->level, g->pieces,
+                           g->game_tick, g->drop_timer, g->game_over, g->paused};
+    return hash_bytes(h, counters, sizeof(counters));
+}
+
+// ---- Checks against a cell-by-cell model ----
+
+static size_t check_step;
+
+static void fail(const tetris_state_t *g, const char *what) {
+    fprintf(stderr, "step %zu, piece %lu: %s\n", check_step, (unsigned long)g->pieces, what);
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        fprintf(stderr, "  %04x |", g->rows[y]);
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            fputc(g->board[y][x] ? '0' + g->board[y][x] : '.', stderr);
+        }
+        fprintf(stderr, "|\n");
+    }
+    exit(1);
+}
+
+static bool model_collides(const tetris_state_t *g, const tetromino_t *piece) {
+    const uint8_t *shape = tetromino_shapes[piece->type][piece->rotation];
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            if (!(shape[y] & (1 << x))) {
+                continue;
+            }
+            int bx = piece->x + x;
+            int by = piece->y + y;
+            if (bx < 0 || bx >= BOARD_WIDTH || by >= BOARD_HEIGHT || g->board[by][bx]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// The rows must be the color plane plus walls and floor, with no full row
+// left standing, and every lock adds four cells while every line takes ten
+static void check_board(const tetris_state_t *g) {
+    int cells = 0;
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        uint16_t expect = BOARD_ROW_EMPTY;
+        for (int x = 0; x < BOARD_WIDTH; x++) {
+            if (g->board[y][x] > TETROMINO_COUNT) {
+                fail(g, "bad color in the board");
+            }
+            if (g->board[y][x]) {
+                expect |= 1u << (x + BOARD_WALL);
+                cells++;
+            }
+        }
+        if (g->rows[y] != expect) {
+            fail(g, "occupancy row does not match the board");
+        }
+        if (g->rows[y] == BOARD_ROW_FULL) {
+            fail(g, "full row was not cleared");
+        }
+    }
+    for (int y = BOARD_HEIGHT; y < BOARD_HEIGHT + BOARD_FLOOR; y++) {
+        if (g->rows[y] != BOARD_ROW_FULL) {
+            fail(g, "floor damaged");
+        }
+    }
+    if (cells != (int)(4 * g->pieces - BOARD_WIDTH * g->lines_cleared)) {
+        fail(g, "cells lost or gained");
+    }
+    if (g->level != g->lines_cleared / 10 + 1) {
+        fail(g, "level does not follow lines");
+    }
+    if (!g->game_over && model_collides(g, &g->current_piece)) {
+        fail(g, "falling piece overlaps the board");
+    }
+}
+
+// Every position a new piece could be tested at, both ways
+static void check_collisions(const tetris_state_t *g) {
+    tetromino_t probe = g->current_piece;
+    for (probe.rotation = 0; probe.rotation < 4; probe.rotation++) {
+        for (probe.y = 0; probe.y <= BOARD_HEIGHT; probe.y++) {
+            for (probe.x = -BOARD_WALL; probe.x < BOARD_WIDTH; probe.x++) {
+                if (tetris_logic_collides(g, &probe) != model_collides(g, &probe)) {
+                    fail(g, "collision disagrees with the model");
+                }
+            }
+        }
+    }
+}
+
+// Score for one step that locked at most one piece
+static void check_score(const tetris_state_t *before, const tetris_state_t *after, uint8_t keys) {
+    static const uint32_t line_scores[] = {0, 100, 300, 500, 800};
+    if (after->pieces - before->pieces > 1) {
+        return;
+    }
+    uint32_t lines = after->lines_cleared - before->lines_cleared;
+    if (lines > 4) {
+        fail(after, "more than four lines from one piece");
+    }
+    uint32_t expect = before->score + line_scores[lines] * before->level;
+    bool active = !before->game_over && !before->paused && !before->exiting;
+    if (active && (keys & TETRIS_KEY_SOFT_DROP)) {
+        expect += 1;
+    }
+    if (active && (keys & TETRIS_KEY_HARD_DROP)) {
+        expect += 2;
+    }
+    if (after->score != expect) {
+        fail(after, "score does not match the lines cleared");
+    }
+}
+
+// One 60 Hz step as the logic task runs it, checked
+static void checked_step(tetris_state_t *g, uint8_t keys) {
+    tetris_state_t before = *g;
+    tetris_logic_input(g, keys);
+    tetris_logic_update(g);
+    check_step++;
+
+    check_board(g);
+    check_score(&before, g, keys);
+    if (g->pieces != before.pieces && !g->game_over) {
+        check_collisions(g);
+    }
+}
+
+// ---- Bot ----
+
+typedef struct {
+    uint8_t keys[SIM_MAX_PLAN];
+    int count;
+} plan_t;
+
+// Rotate and shift together, one press of each per step, and hard drop
+// with the last one
+static void make_plan(plan_t *plan, int rotations, int dx) {
+    int moves = abs(dx);
+    int n = (rotations > moves) ? rotations : moves;
+    if (n == 0) {
+        n = 1;
+    }
+    for (int i = 0; i < n; i++) {
+        plan->keys[i] = 0;
+        if (i < rotations) {
+            plan->keys[i] |= TETRIS_KEY_ROTATE;
+        }
+        if (i < moves) {
+            plan->keys[i] |= (dx < 0) ? TETRIS_KEY_LEFT : TETRIS_KEY_RIGHT;
+        }
+    }
+    plan->keys[n - 1] |= TETRIS_KEY_HARD_DROP;
+    plan->count = n;
+}
+
+// Weights from a well-known hand-tuned Tetris heuristic, scaled by 100:
+// aggregate height, lines, holes and bumpiness
+static int rate_board(const tetris_state_t *g, uint32_t lines) {
+    int height[BOARD_WIDTH];
+    int aggregate = 0, holes = 0, bumpiness = 0;
+    for (int x = 0; x < BOARD_WIDTH; x++) {
+        uint16_t bit = 1u << (x + BOARD_WALL);
+        int top = 0;
+        while (top < BOARD_HEIGHT && !(g->rows[top] & bit)) {
+            top++;
+        }
+        height[x] = BOARD_HEIGHT - top;
+        aggregate += height[x];
+        for (int y = top + 1; y < BOARD_HEIGHT; y++) {
+            holes += !(g->rows[y] & bit);
+        }
+        if (x > 0) {
+            bumpiness += abs(height[x] - height[x - 1]);
+        }
+    }
+    return -51 * aggregate + 76 * (int)lines - 36 * holes - 18 * bumpiness;
+}
+
+// Try every rotation and column on a copy and keep the best
+static void choose_plan(const tetris_state_t *g, plan_t *best) {
+    int best_rating = INT_MIN;
+    make_plan(best, 0, 0);
+    for (int rotations = 0; rotations < 4; rotations++) {
+        for (int dx = -BOARD_WIDTH / 2; dx <= BOARD_WIDTH / 2; dx++) {
+            plan_t plan;
+            make_plan(&plan, rotations, dx);
+            tetris_state_t trial = *g;
+            for (int i = 0; i < plan.count; i++) {
+                tetris_logic_input(&trial, plan.keys[i]);
+                tetris_logic_update(&trial);
+            }
+            // Topping out is worse than any board
+            int rating = trial.game_over ? INT_MIN
+                                         : rate_board(&trial, trial.lines_cleared - g->lines_cleared);
+            if (rating > best_rating) {
+                *best = plan;
+                best_rating = rating;
+            }
+        }
+    }
+}
+
+static void bot_play(uint32_t seed, uint32_t max_pieces) {
+    uint32_t pieces = 0;
+    while (pieces < max_pieces) {
+        tetris_state_t g;
+        tetris_logic_reset(&g, seed);
+        record_game(seed);
+        check_collisions(&g);
+        while (!g.game_over && pieces + g.pieces < max_pieces) {
+            plan_t plan;
+            choose_plan(&g, &plan);
+            for (int i = 0; i < plan.count; i++) {
+                record_step(plan.keys[i]);
+                checked_step(&g, plan.keys[i]);
+            }
+        }
+        pieces += g.pieces;
+        if (!quiet) {
+            printf("seed %lu: %lu pieces, %lu lines, score %lu, level %lu%s\n",
+                   (unsigned long)seed, (unsigned long)g.pieces, (unsigned long)g.lines_cleared,
+                   (unsigned long)g.score, (unsigned long)g.level, g.game_over ? ", topped out" : "");
+        }
+        seed++;
+    }
+}
+
+// ---- Scripts ----
+
+static void read_script(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "cannot read %s\n", path);
+        exit(1);
+    }
+    char line[128];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        char *p = line + strspn(line, " \t");
+        if (*p == '#' || *p == '\n' || *p == '\0') {
+            continue;
+        }
+        unsigned long seed;
+        if (sscanf(p, "seed %lu", &seed) == 1) {
+            record_game(seed);
+            continue;
+        }
+        if (game_count == 0) {
+            record_game(1);
+        }
+
+        uint8_t keys = 0;
+        for (; *p && !strchr(" \t\r\n", *p); p++) {
+            size_t b = 0;
+            while (b < BUTTON_COUNT && buttons[b].name != *p) {
+                b++;
+            }
+            if (b < BUTTON_COUNT) {
+                keys |= buttons[b].key;
+            } else if (*p != '.') {
+                fprintf(stderr, "%s:%d: unknown button '%c'\n", path, line_no, *p);
+                exit(1);
+            }
+        }
+        unsigned long repeat = 1;
+        sscanf(p, " x%lu", &repeat);
+        while (repeat--) {
+            record_step(keys);
+        }
+    }
+    fclose(f);
+}
+
+static void write_keys(FILE *f, uint8_t keys, size_t repeat) {
+    if (keys == 0) {
+        fputc('.', f);
+    }
+    for (size_t b = 0; b < BUTTON_COUNT; b++) {
+        if (keys & buttons[b].key) {
+            fputc(buttons[b].name, f);
+        }
+    }
+    if (repeat > 1) {
+        fprintf(f, " x%zu", repeat);
+    }
+    fputc('\n', f);
+}
+
+static void write_script(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "cannot write %s\n", path);
+        exit(1);
+    }
+    for (size_t i = 0; i < game_count; i++) {
+        fprintf(f, "seed %lu\n", (unsigned long)games[i].seed);
+        const uint8_t *s = steps + games[i].first;
+        size_t run = 0;
+        for (size_t j = 0; j < games[i].count; j++) {
+            run++;
+            if (j + 1 == games[i].count || s[j + 1] != s[j]) {
+                write_keys(f, s[j], run);
+                run = 0;
+            }
+        }
+    }
+    fclose(f);
+}
+
+// ---- Replay ----
+
+// Run every recorded game, optionally checked; returns the checksum
+static uint32_t replay(bool checked, uint32_t *pieces) {
+    uint32_t h = 2166136261u;
+    *pieces = 0;
+    for (size_t i = 0; i < game_count; i++) {
+        tetris_state_t g;
+        tetris_logic_reset(&g, games[i].seed);
+        const uint8_t *s = steps + games[i].first;
+        for (size_t j = 0; j < games[i].count; j++) {
+            if (checked) {
+                checked_step(&g, s[j]);
+            } else {
+                tetris_logic_input(&g, s[j]);
+                tetris_logic_update(&g);
+            }
+        }
+        h = hash_state(h, &g);
+        *pieces += g.pieces;
+    }
+    return h;
+}
+
+static uint32_t replay_engine(uint32_t *pieces) {
+    return replay(false, pieces);
+}
+
+// The same games through the reference engine; the checksum covers what
+// both engines have in common
+static uint32_t replay_reference(uint32_t *pieces) {
+    uint32_t h = 2166136261u;
+    *pieces = 0;
+    for (size_t i = 0; i < game_count; i++) {
+        reference_state_t g;
+        reference_reset(&g, games[i].seed);
+        const uint8_t *s = steps + games[i].first;
+        for (size_t j = 0; j < games[i].count; j++) {
+            reference_input(&g, s[j]);
+            reference_update(&g);
+        }
+        h = hash_bytes(h, g.board, sizeof(g.board));
+        h = hash_bytes(h, &g.score, sizeof(g.score));
+        *pieces += g.pieces;
+    }
+    return h;
+}
+
+// Every game must end the same way in both engines
+static void compare_reference(void) {
+    for (size_t i = 0; i < game_count; i++) {
+        tetris_state_t g;
+        reference_state_t r;
+        tetris_logic_reset(&g, games[i].seed);
+        reference_reset(&r, games[i].seed);
+        const uint8_t *s = steps + games[i].first;
+        for (size_t j = 0; j < games[i].count; j++) {
+            tetris_logic_input(&g, s[j]);
+            tetris_logic_update(&g);
+            reference_input(&r, s[j]);
+            reference_update(&r);
+        }
+        if (memcmp(g.board, r.board, sizeof(g.board)) != 0 ||
+            memcmp(&g.current_piece, &r.current_piece, sizeof(g.current_piece)) != 0 ||
+            memcmp(&g.next_piece, &r.next_piece, sizeof(g.next_piece)) != 0 ||
+            g.score != r.score || g.lines_cleared != r.lines_cleared || g.level != r.level ||
+            g.pieces != r.pieces || g.game_tick != r.game_tick || g.game_over != r.game_over) {
+            fprintf(stderr, "game %zu (seed %lu) ends differently in the reference engine\n",
+                    i, (unsigned long)games[i].seed);
+            exit(1);
+        }
+    }
+}
+
+// Replay with nothing else running until the time is long enough to
+// measure; every run must give the same checksum. Returns ns per replay.
+static double time_replays(uint32_t (*run)(uint32_t *pieces), const char *name) {
+    uint32_t pieces;
+    uint32_t expect = run(&pieces);
+    int runs = 0;
+    int64_t start = now_ns(), elapsed;
+    do {
+        uint32_t again = run(&pieces);
+        if (again != expect) {
+            fprintf(stderr, "%s replay %d gave checksum %08lx, expected %08lx\n",
+                    name, runs, (unsigned long)again, (unsigned long)expect);
+            exit(1);
+        }
+        runs++;
+        elapsed = now_ns() - start;
+    } while (elapsed < SIM_MIN_TIMED_NS);
+
+    double per_replay = (double)elapsed / runs;
+    printf("%s: %.1f ns/piece, %.1f ns/step (%d replays)\n", name,
+           per_replay / (pieces ? pieces : 1), per_replay / step_count, runs);
+    return per_replay;
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = 1;
+    uint32_t max_pieces = 10000;
+    const char *script_in = NULL, *script_out = NULL;
+    bool compare = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:n:r:w:bq")) != -1) {
+        switch (opt) {
+            case 's': seed = strtoul(optarg, NULL, 0); break;
+            case 'n': max_pieces = strtoul(optarg, NULL, 0); break;
+            case 'r': script_in = optarg; break;
+            case 'w': script_out = optarg; break;
+            case 'b': compare = true; break;
+            case 'q': quiet = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-s seed] [-n pieces] [-w script] [-b] [-q]\n"
+                                "       %s -r script [-b] [-q]\n", argv[0], argv[0]);
+                return 1;
+        }
+    }
+
+    uint32_t pieces;
+    uint32_t checksum;
+    if (script_in) {
+        read_script(script_in);
+        checksum = replay(true, &pieces);
+    } else {
+        bot_play(seed, max_pieces);
+        checksum = replay(false, &pieces);
+    }
+    if (script_out) {
+        write_script(script_out);
+    }
+    if (step_count == 0) {
+        fprintf(stderr, "nothing to play\n");
+        return 1;
+    }
+
+    printf("%zu games, %lu pieces, %zu steps, checksum %08lx\n", game_count,
+           (unsigned long)pieces, step_count, (unsigned long)checksum);
+
+    // Engine alone: the same keys again, unchecked
+    double engine_ns = time_replays(replay_engine, "engine");
+    if (compare) {
+        compare_reference();
+        double reference_ns = time_replays(replay_reference, "reference");
+        printf("bitboard engine is %.2fx the reference\n", reference_ns / engine_ns);
+    }
+    return 0;
+}
@@ -1,18 +1,21 @@
 /**
  * @file tetris_game.c
- * @brief Tetris game implementation
+ * @brief Tetris on the badge: buttons, rendering and the game tasks
  */
 
 #include "tetris_game.h"
 #include "lcd_driver.h"
-#include "driver/gpio.h"
+#include "lcd_tilemap.h"
+#include "game_tasks.h"
+#include "game_profile.h"
+#include "ebadge_input.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
-#include "esp_timer.h"
 #include "esp_random.h"
 #include "esp_ota_ops.h"
 #include "esp_partition.h"
+#include "sdkconfig.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -21,58 +24,33 @@ static const char *TAG = "tetris";
 // Game state
 static tetris_state_t game;
 
-// Tetromino shapes (4x4 grid, 4 rotations each)
-// 1 = filled block, 0 = empty
-static const uint8_t tetromino_shapes[TETROMINO_COUNT][4][4][4] = {
-    // I piece (Cyan)
-    {
-        {{0,0,0,0}, {1,1,1,1}, {0,0,0,0}, {0,0,0,0}},
-        {{0,0,1,0}, {0,0,1,0}, {0,0,1,0}, {0,0,1,0}},
-        {{0,0,0,0}, {0,0,0,0}, {1,1,1,1}, {0,0,0,0}},
-        {{0,1,0,0}, {0,1,0,0}, {0,1,0,0}, {0,1,0,0}}
-    },
-    // O piece (Yellow)
-    {
-        {{0,1,1,0}, {0,1,1,0}, {0,0,0,0}, {0,0,0,0}},
-        {{0,1,1,0}, {0,1,1,0}, {0,0,0,0}, {0,0,0,0}},
-        {{0,1,1,0}, {0,1,1,0}, {0,0,0,0}, {0,0,0,0}},
-        {{0,1,1,0}, {0,1,1,0}, {0,0,0,0}, {0,0,0,0}}
-    },
-    // T piece (Purple)
-    {
-        {{0,1,0,0}, {1,1,1,0}, {0,0,0,0}, {0,0,0,0}},
-        {{0,1,0,0}, {0,1,1,0}, {0,1,0,0}, {0,0,0,0}},
-        {{0,0,0,0}, {1,1,1,0}, {0,1,0,0}, {0,0,0,0}},
-        {{0,1,0,0}, {1,1,0,0}, {0,1,0,0}, {0,0,0,0}}
-    },
-    // S piece (Green)
-    {
-        {{0,1,1,0}, {1,1,0,0}, {0,0,0,0}, {0,0,0,0}},
-        {{0,1,0,0}, {0,1,1,0}, {0,0,1,0}, {0,0,0,0}},
-        {{0,0,0,0}, {0,1,1,0}, {1,1,0,0}, {0,0,0,0}},
-        {{1,0,0,0}, {1,1,0,0}, {0,1,0,0}, {0,0,0,0}}
-    },
-    // Z piece (Red)
-    {
-        {{1,1,0,0}, {0,1,1,0}, {0,0,0,0}, {0,0,0,0}},
-        {{0,0,1,0}, {0,1,1,0}, {0,1,0,0}, {0,0,0,0}},
-        {{0,0,0,0}, {1,1,0,0}, {0,1,1,0}, {0,0,0,0}},
-        {{0,1,0,0}, {1,1,0,0}, {1,0,0,0}, {0,0,0,0}}
-    },
-    // J piece (Blue)
-    {
-        {{1,0,0,0}, {1,1,1,0}, {0,0,0,0}, {0,0,0,0}},
-        {{0,1,1,0}, {0,1,0,0}, {0,1,0,0}, {0,0,0,0}},
-        {{0,0,0,0}, {1,1,1,0}, {0,0,1,0}, {0,0,0,0}},
-        {{0,1,0,0}, {0,1,0,0}, {1,1,0,0}, {0,0,0,0}}
-    },
-    // L piece (Orange)
-    {
-        {{0,0,1,0}, {1,1,1,0}, {0,0,0,0}, {0,0,0,0}},
-        {{0,1,0,0}, {0,1,0,0}, {0,1,1,0}, {0,0,0,0}},
-        {{0,0,0,0}, {1,1,1,0}, {1,0,0,0}, {0,0,0,0}},
-        {{1,1,0,0}, {0,1,0,0}, {0,1,0,0}, {0,0,0,0}}
-    }
+// Board cells as drawn on screen: 0 = empty, 1-7 = tetromino color
+static lcd_tilemap_t board_map;
+
+// Snapshot being drawn; the render callback reads it during lcd_flush
+static const tetris_frame_t *shown;
+
+// What the board tile map holds: the color plane and the piece over it
+static uint8_t drawn_board[BOARD_HEIGHT][BOARD_WIDTH];
+static tetromino_t drawn_piece;
+
+// Score line fields, each invalidated on its own when its value changes
+#define TEXT_GLYPH  (8 * CONFIG_EBADGE_LCD_FONT_SCALE)
+
+typedef enum {
+    HUD_SCORE,
+    HUD_LINES,
+    HUD_LEVEL,
+    HUD_FIELDS
+} hud_field_t;
+
+static const struct {
+    int x, y;
+    const char *format;
+} hud_layout[HUD_FIELDS] = {
+    [HUD_SCORE] = {10, 10, "SCORE:%lu"},
+    [HUD_LINES] = {10, 25, "LINES:%lu"},
+    [HUD_LEVEL] = {170, 10, "LVL:%lu"},
 };
 
 // Tetromino colors
@@ -86,26 +64,29 @@ static const uint16_t tetromino_colors[TETROMINO_COUNT] = {
     COLOR_ORANGE   // L
 };
 
-// Button state tracking
-static bool button_pressed[6] = {false};
-static uint32_t button_last_press[6] = {0};
-#define BUTTON_DEBOUNCE_MS 50
+// Buttons pressed since the last input step
+static ebadge_input_frame_t buttons;
+
+// What each button does in the game
+static const uint8_t button_keys[EBADGE_BUTTON_COUNT] = {
+    [EBADGE_BUTTON_UP] = TETRIS_KEY_ROTATE,
+    [EBADGE_BUTTON_DOWN] = TETRIS_KEY_SOFT_DROP,
+    [EBADGE_BUTTON_LEFT] = TETRIS_KEY_LEFT,
+    [EBADGE_BUTTON_RIGHT] = TETRIS_KEY_RIGHT,
+    [EBADGE_BUTTON_A] = TETRIS_KEY_HARD_DROP,
+    [EBADGE_BUTTON_B] = TETRIS_KEY_BACK,
+};
 
 // Forward declarations
 static void init_buttons(void);
-static bool read_button(int gpio_num, int btn_idx);
-static void spawn_piece(tetromino_t *piece, tetromino_type_t type);
-static bool check_collision(tetromino_t *piece);
-static void lock_piece(void);
-static void clear_lines(void);
-static void rotate_piece(void);
-static void move_piece(int dx, int dy);
-static void hard_drop(void);
-static void draw_board(void);
-static void draw_piece(tetromino_t *piece, bool erase);
+static void draw_block(void *arg);
+static void sync_board(const tetris_frame_t *frame);
+static int format_hud(char *buf, size_t size, const tetris_frame_t *frame, hud_field_t field);
+static void log_changes(uint32_t lines_before, bool over_before);
 static void draw_next_piece(void);
 static void draw_ui(void);
-static int get_drop_interval(void);
+static void render_scene(void *arg);
+static void invalidate_changes(const tetris_frame_t *frame);
 
 esp_err_t tetris_init(void) {
     ESP_LOGI(TAG, "Initializing Tetris game");
@@ -116,226 +97,63 @@ esp_err_t tetris_init(void) {
     // Initialize buttons
     init_buttons();
     
+    // Frames are composed off-screen and only changed bands are sent
+    lcd_set_renderer(render_scene, NULL);
+    
+    // Board cells come from a tile map, so a move only resends the cells
+    // the piece left and entered
+    ESP_ERROR_CHECK(lcd_tilemap_init(&board_map, BOARD_OFFSET_X, BOARD_OFFSET_Y,
+                                     BOARD_WIDTH, BOARD_HEIGHT, TETROMINO_COUNT + 1));
+    for (int t = 1; t <= TETROMINO_COUNT; t++) {
+        lcd_tilemap_define(&board_map, t, draw_block, (void *)(uintptr_t)t);
+    }
+    
+    // Score, lines and the next-piece preview change a few glyphs or cells
+    // at a time; the shadow keeps the rest of the header off the bus
+    ESP_ERROR_CHECK(lcd_set_shadow(0, 0, SCREEN_WIDTH, 100));
+    
     // Reset game state
     tetris_reset_game();
     
+    // Initial render: repaint everything on the first flush
+    lcd_invalidate(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    
     ESP_LOGI(TAG, "Game initialized successfully");
     return ESP_OK;
 }
 
 static void init_buttons(void) {
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL<<BTN_UP) | (1ULL<<BTN_DOWN) | 
-                        (1ULL<<BTN_LEFT) | (1ULL<<BTN_RIGHT) |
-                        (1ULL<<BTN_A) | (1ULL<<BTN_B),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
+    // Edges are caught by interrupt and queued for the next input step
+    const ebadge_input_config_t config = {
+        .gpio = {
+            [EBADGE_BUTTON_UP] = BTN_UP,
+            [EBADGE_BUTTON_DOWN] = BTN_DOWN,
+            [EBADGE_BUTTON_LEFT] = BTN_LEFT,
+            [EBADGE_BUTTON_RIGHT] = BTN_RIGHT,
+            [EBADGE_BUTTON_A] = BTN_A,
+            [EBADGE_BUTTON_B] = BTN_B,
+        },
     };
-    gpio_config(&io_conf);
-}
-
-static bool read_button(int gpio_num, int btn_idx) {
-    uint32_t now = esp_timer_get_time() / 1000;  // ms
-    if (gpio_get_level(gpio_num) == 0) {  // Active low
-        if (!button_pressed[btn_idx]) {
-            if (now - button_last_press[btn_idx] > BUTTON_DEBOUNCE_MS) {
-                button_pressed[btn_idx] = true;
-                button_last_press[btn_idx] = now;
-                return true;
-            }
-        }
-    } else {
-        button_pressed[btn_idx] = false;
-    }
-    return false;
+    ESP_ERROR_CHECK(ebadge_input_init(&config));
 }
 
 void tetris_reset_game(void) {
     ESP_LOGI(TAG, "Resetting game");
-    
-    // Clear board
-    memset(game.board, 0, sizeof(game.board));
-    
-    // Initialize game state
-    game.score = 0;
-    game.lines_cleared = 0;
-    game.level = 1;
-    game.game_over = false;
-    game.paused = false;
-    game.drop_timer = 0;
-    game.drop_interval = get_drop_interval();
-    game.game_tick = 0;
-    
-    // Spawn first pieces
-    spawn_piece(&game.current_piece, esp_random() % TETROMINO_COUNT);
-    spawn_piece(&game.next_piece, esp_random() % TETROMINO_COUNT);
-    
-    // Initial render
-    lcd_fill_screen(COLOR_BLACK);
-    draw_board();
-    draw_ui();
-    draw_next_piece();
-}
-
-static void spawn_piece(tetromino_t *piece, tetromino_type_t type) {
-    piece->type = type;
-    piece->x = BOARD_WIDTH / 2 - 2;  // Center horizontally
-    piece->y = 0;
-    piece->rotation = 0;
-    piece->color = tetromino_colors[type];
-}
-
-static bool check_collision(tetromino_t *piece) {
-    const uint8_t (*shape)[4] = tetromino_shapes[piece->type][piece->rotation];
-    
-    for (int y = 0; y < 4; y++) {
-        for (int x = 0; x < 4; x++) {
-            if (shape[y][x]) {
-                int board_x = piece->x + x;
-                int board_y = piece->y + y;
-                
-                // Check boundaries
-                if (board_x < 0 || board_x >= BOARD_WIDTH || 
-                    board_y < 0 || board_y >= BOARD_HEIGHT) {
-                    return true;
-                }
-                
-                // Check board collision
-                if (game.board[board_y][board_x] != 0) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
+    tetris_logic_reset(&game, esp_random());
 }
 
-static void lock_piece(void) {
-    const uint8_t (*shape)[4] = tetromino_shapes[game.current_piece.type][game.current_piece.rotation];
-    
-    // Add piece to board
-    for (int y = 0; y < 4; y++) {
-        for (int x = 0; x < 4; x++) {
-            if (shape[y][x]) {
-                int board_x = game.current_piece.x + x;
-                int board_y = game.current_piece.y + y;
-                if (board_y >= 0 && board_y < BOARD_HEIGHT && 
-                    board_x >= 0 && board_x < BOARD_WIDTH) {
-                    game.board[board_y][board_x] = game.current_piece.type + 1;
-                }
-            }
-        }
+// The rules do not log; report what a step did
+static void log_changes(uint32_t lines_before, bool over_before) {
+    if (game.lines_cleared != lines_before) {
+        ESP_LOGI(TAG, "Cleared %lu lines! Score: %lu",
+                 (unsigned long)(game.lines_cleared - lines_before), (unsigned long)game.score);
     }
-    
-    // Clear completed lines
-    clear_lines();
-    
-    // Spawn next piece
-    game.current_piece = game.next_piece;
-    spawn_piece(&game.next_piece, esp_random() % TETROMINO_COUNT);
-    
-    // Check game over
-    if (check_collision(&game.current_piece)) {
-        game.game_over = true;
+    if (game.game_over && !over_before) {
         ESP_LOGI(TAG, "Game Over! Score: %lu", (unsigned long)game.score);
     }
 }
 
-static void clear_lines(void) {
-    int lines_cleared_now = 0;
-    
-    // Check each row from bottom to top
-    for (int y = BOARD_HEIGHT - 1; y >= 0; y--) {
-        bool full = true;
-        for (int x = 0; x < BOARD_WIDTH; x++) {
-            if (game.board[y][x] == 0) {
-                full = false;
-                break;
-            }
-        }
-        
-        if (full) {
-            lines_cleared_now++;
-            
-            // Move all rows above down
-            for (int yy = y; yy > 0; yy--) {
-                for (int x = 0; x < BOARD_WIDTH; x++) {
-                    game.board[yy][x] = game.board[yy-1][x];
-                }
-            }
-            
-            // Clear top row
-            for (int x = 0; x < BOARD_WIDTH; x++) {
-                game.board[0][x] = 0;
-            }
-            
-            y++;  // Check this row again
-        }
-    }
-    
-    if (lines_cleared_now > 0) {
-        // Scoring: 1 line=100, 2=300, 3=500, 4=800
-        static const uint32_t line_scores[] = {0, 100, 300, 500, 800};
-        game.score += line_scores[lines_cleared_now] * game.level;
-        game.lines_cleared += lines_cleared_now;
-        
-        // Level up every 10 lines
-        game.level = game.lines_cleared / 10 + 1;
-        game.drop_interval = get_drop_interval();
-        
-        ESP_LOGI(TAG, "Cleared %d lines! Score: %lu", lines_cleared_now, (unsigned long)game.score);
-    }
-}
-
-static void rotate_piece(void) {
-    tetromino_t test_piece = game.current_piece;
-    test_piece.rotation = (test_piece.rotation + 1) % 4;
-    
-    if (!check_collision(&test_piece)) {
-        game.current_piece.rotation = test_piece.rotation;
-    }
-}
-
-static void move_piece(int dx, int dy) {
-    tetromino_t test_piece = game.current_piece;
-    test_piece.x += dx;
-    test_piece.y += dy;
-    
-    if (!check_collision(&test_piece)) {
-        game.current_piece.x = test_piece.x;
-        game.current_piece.y = test_piece.y;
-    } else if (dy > 0) {
-        // Hit bottom, lock piece
-        lock_piece();
-        game.drop_timer = 0;
-    }
-}
-
-static void hard_drop(void) {
-    while (true) {
-        tetromino_t test_piece = game.current_piece;
-        test_piece.y++;
-        
-        if (check_collision(&test_piece)) {
-            lock_piece();
-            game.drop_timer = 0;
-            game.score += 2;  // Bonus for hard drop
-            break;
-        }
-        game.current_piece.y++;
-    }
-}
-
-static int get_drop_interval(void) {
-    // Drop faster as level increases (60 ticks = 1 second at 60 FPS)
-    int base = 60;
-    int reduction = (game.level - 1) * 5;
-    int interval = base - reduction;
-    return (interval < 10) ? 10 : interval;  // Minimum 10 ticks
-}
-
+// Runs on the render task, which owns the display
 static void return_to_launcher(void) {
     ESP_LOGI(TAG, "Returning to launcher...");
     
@@ -363,131 +181,151 @@ static void return_to_launcher(void) {
     }
 }
 
+// Buttons to game keys; Up while paused belongs to the profiler
 void tetris_handle_input(void) {
-    if (game.game_over) {
-        // Button B returns to launcher
-        if (read_button(BTN_B, 5)) {
-            return_to_launcher();
-        }
-        return;
+    ebadge_input_frame(&buttons);
+    if (game.paused && !game.game_over && !game.exiting &&
+        ebadge_input_pressed(&buttons, EBADGE_BUTTON_UP)) {
+        game_profile_toggle_overlay();
     }
     
-    if (game.paused) {
-        // Button A - unpause
-        if (read_button(BTN_A, 4)) {
-            game.paused = false;
+    uint8_t keys = 0;
+    for (int b = 0; b < EBADGE_BUTTON_COUNT; b++) {
+        if (ebadge_input_pressed(&buttons, b)) {
+            keys |= button_keys[b];
         }
-        // Button B - return to launcher
-        if (read_button(BTN_B, 5)) {
-            return_to_launcher();
-        }
-        return;
     }
     
-    // Rotate
-    if (read_button(BTN_UP, 0)) {
-        rotate_piece();
+    uint32_t lines = game.lines_cleared;
+    bool over = game.game_over;
+    tetris_logic_input(&game, keys);
+    log_changes(lines, over);
+}
+
+void tetris_update(void) {
+    uint32_t lines = game.lines_cleared;
+    bool over = game.game_over;
+    tetris_logic_update(&game);
+    log_changes(lines, over);
+}
+
+void tetris_snapshot(tetris_frame_t *frame) {
+    memcpy(frame->board, game.board, sizeof(frame->board));
+    frame->current_piece = game.current_piece;
+    frame->next_piece = game.next_piece;
+    frame->score = game.score;
+    frame->lines_cleared = game.lines_cleared;
+    frame->level = game.level;
+    frame->game_over = game.game_over;
+    frame->paused = game.paused;
+    frame->exiting = game.exiting;
+}
+
+void tetris_render(const tetris_frame_t *frame) {
+    if (frame->exiting) {
+        return_to_launcher();
+        return;
     }
+    shown = frame;
     
-    // Move left
-    if (read_button(BTN_LEFT, 2)) {
-        move_piece(-1, 0);
+    // Changed cells go straight to the panel unless an overlay covers them
+    sync_board(frame);
+    if (frame->game_over || frame->paused) {
+        lcd_tilemap_invalidate(&board_map);
+    } else {
+        lcd_tilemap_flush(&board_map);
     }
     
-    // Move right
-    if (read_button(BTN_RIGHT, 3)) {
-        move_piece(1, 0);
-    }
+    invalidate_changes(frame);
+    lcd_flush();
+}
+
+// Full scene, recorded by lcd_flush once per frame
+static void render_scene(void *arg) {
+    lcd_draw_rect(BOARD_OFFSET_X - 2, BOARD_OFFSET_Y - 2,
+                  BOARD_WIDTH * BLOCK_SIZE + 4, BOARD_HEIGHT * BLOCK_SIZE + 4,
+                  COLOR_WHITE);
+    lcd_tilemap_draw(&board_map);
+    draw_ui();
+    draw_next_piece();
+    game_profile_draw_overlay();
+}
+
+// Mark the screen areas whose contents changed since the last frame
+static void invalidate_changes(const tetris_frame_t *frame) {
+    static tetris_frame_t drawn;
     
-    // Soft drop (move down faster)
-    if (read_button(BTN_DOWN, 1)) {
-        move_piece(0, 1);
-        game.score += 1;  // Small bonus for soft drop
+    if (drawn.next_piece.type != frame->next_piece.type) {
+        lcd_invalidate(170, 35, 4 * BLOCK_SIZE, 4 * BLOCK_SIZE + 15);
     }
     
-    // Hard drop
-    if (read_button(BTN_A, 4)) {
-        hard_drop();
+    // Only the text of a changed field, as wide as its longer version
+    for (int f = 0; f < HUD_FIELDS; f++) {
+        char old_text[32], new_text[32];
+        int old_len = format_hud(old_text, sizeof(old_text), &drawn, f);
+        int new_len = format_hud(new_text, sizeof(new_text), frame, f);
+        if (old_len != new_len || strcmp(old_text, new_text) != 0) {
+            int len = (old_len > new_len) ? old_len : new_len;
+            lcd_invalidate(hud_layout[f].x, hud_layout[f].y, len * TEXT_GLYPH, TEXT_GLYPH);
+        }
     }
     
-    // Pause game (Button B during gameplay)
-    if (read_button(BTN_B, 5)) {
-        game.paused = true;
+    if (drawn.game_over != frame->game_over || drawn.paused != frame->paused) {
+        lcd_invalidate(40, SCREEN_HEIGHT/2 - 30, 160, 65);
     }
+    
+    drawn = *frame;
 }
 
-void tetris_update(void) {
-    if (game.game_over || game.paused) return;
-    
-    game.game_tick++;
-    game.drop_timer++;
-    
-    // Auto-drop piece
-    if (game.drop_timer >= game.drop_interval) {
-        move_piece(0, 1);
-        game.drop_timer = 0;
-    }
+// Tile image for board cell value `arg`, in tile-local coordinates
+static void draw_block(void *arg) {
+    uint16_t color = tetromino_colors[(uintptr_t)arg - 1];
+    lcd_fill_rect(0, 0, BLOCK_SIZE, BLOCK_SIZE, color);
+    lcd_draw_rect(0, 0, BLOCK_SIZE, BLOCK_SIZE, COLOR_WHITE);
 }
 
-void tetris_render(void) {
-    // Redraw board
-    draw_board();
-    
-    // Draw current piece
-    draw_piece(&game.current_piece, false);
-    
-    // Draw UI
-    draw_ui();
-    draw_next_piece();
+// Board cell as shown: the falling piece covers the color plane
+static uint8_t cell_id(const tetris_frame_t *frame, int x, int y) {
+    const tetromino_t *piece = &frame->current_piece;
+    int row = y - piece->y;
+    int col = x - piece->x;
+    if (row >= 0 && row < 4 && col >= 0 && col < 4 &&
+        (tetromino_shapes[piece->type][piece->rotation][row] & (1 << col))) {
+        return piece->type + 1;
+    }
+    return frame->board[y][x];
 }
 
-static void draw_board(void) {
-    // Draw border
-    lcd_draw_rect(BOARD_OFFSET_X - 2, BOARD_OFFSET_Y - 2, 
-                  BOARD_WIDTH * BLOCK_SIZE + 4, BOARD_HEIGHT * BLOCK_SIZE + 4, 
-                  COLOR_WHITE);
-    
-    // Draw blocks
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-        for (int x = 0; x < BOARD_WIDTH; x++) {
-            int px = BOARD_OFFSET_X + x * BLOCK_SIZE;
-            int py = BOARD_OFFSET_Y + y * BLOCK_SIZE;
-            
-            if (game.board[y][x] == 0) {
-                lcd_fill_rect(px, py, BLOCK_SIZE, BLOCK_SIZE, COLOR_BLACK);
-            } else {
-                uint16_t color = tetromino_colors[game.board[y][x] - 1];
-                lcd_fill_rect(px, py, BLOCK_SIZE, BLOCK_SIZE, color);
-                lcd_draw_rect(px, py, BLOCK_SIZE, BLOCK_SIZE, COLOR_WHITE);
+static void sync_footprint(const tetris_frame_t *frame, const tetromino_t *piece) {
+    const uint8_t *shape = tetromino_shapes[piece->type][piece->rotation];
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            int bx = piece->x + x;
+            int by = piece->y + y;
+            if ((shape[y] & (1 << x)) && bx >= 0 && bx < BOARD_WIDTH && by < BOARD_HEIGHT) {
+                lcd_tilemap_set(&board_map, bx, by, cell_id(frame, bx, by));
             }
         }
     }
 }
 
-static void draw_piece(tetromino_t *piece, bool erase) {
-    const uint8_t (*shape)[4] = tetromino_shapes[piece->type][piece->rotation];
-    
-    for (int y = 0; y < 4; y++) {
-        for (int x = 0; x < 4; x++) {
-            if (shape[y][x]) {
-                int board_x = piece->x + x;
-                int board_y = piece->y + y;
-                
-                if (board_x >= 0 && board_x < BOARD_WIDTH && 
-                    board_y >= 0 && board_y < BOARD_HEIGHT) {
-                    int px = BOARD_OFFSET_X + board_x * BLOCK_SIZE;
-                    int py = BOARD_OFFSET_Y + board_y * BLOCK_SIZE;
-                    
-                    if (erase) {
-                        lcd_fill_rect(px, py, BLOCK_SIZE, BLOCK_SIZE, COLOR_BLACK);
-                    } else {
-                        lcd_fill_rect(px, py, BLOCK_SIZE, BLOCK_SIZE, piece->color);
-                        lcd_draw_rect(px, py, BLOCK_SIZE, BLOCK_SIZE, COLOR_WHITE);
-                    }
-                }
+// Update only the cells that can have changed: rows the color plane
+// changed in (a lock or line clear), and the cells the piece left and
+// entered. Each is set once to its final id, so a cell the piece still
+// covers is not marked dirty.
+static void sync_board(const tetris_frame_t *frame) {
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        if (memcmp(drawn_board[y], frame->board[y], BOARD_WIDTH) != 0) {
+            for (int x = 0; x < BOARD_WIDTH; x++) {
+                lcd_tilemap_set(&board_map, x, y, cell_id(frame, x, y));
             }
+            memcpy(drawn_board[y], frame->board[y], BOARD_WIDTH);
         }
     }
+    
+    sync_footprint(frame, &drawn_piece);
+    sync_footprint(frame, &frame->current_piece);
+    drawn_piece = frame->current_piece;
 }
 
 static void draw_next_piece(void) {
@@ -501,40 +339,44 @@ static void draw_next_piece(void) {
     lcd_fill_rect(preview_x, preview_y, 4 * BLOCK_SIZE, 4 * BLOCK_SIZE, COLOR_BLACK);
     
     // Draw next piece
-    const uint8_t (*shape)[4] = tetromino_shapes[game.next_piece.type][0];
+    const uint8_t *shape = tetromino_shapes[shown->next_piece.type][0];
     for (int y = 0; y < 4; y++) {
         for (int x = 0; x < 4; x++) {
-            if (shape[y][x]) {
+            if (shape[y] & (1 << x)) {
                 int px = preview_x + x * BLOCK_SIZE;
                 int py = preview_y + y * BLOCK_SIZE;
-                lcd_fill_rect(px, py, BLOCK_SIZE - 1, BLOCK_SIZE - 1, game.next_piece.color);
+                lcd_fill_rect(px, py, BLOCK_SIZE - 1, BLOCK_SIZE - 1, tetromino_colors[shown->next_piece.type]);
             }
         }
     }
 }
 
+static int format_hud(char *buf, size_t size, const tetris_frame_t *frame, hud_field_t field) {
+    uint32_t value;
+    switch (field) {
+    case HUD_SCORE: value = frame->score; break;
+    case HUD_LINES: value = frame->lines_cleared; break;
+    default:        value = frame->level; break;
+    }
+    return snprintf(buf, size, hud_layout[field].format, (unsigned long)value);
+}
+
 static void draw_ui(void) {
-    // Draw score
+    // Score, lines and level
     char buf[32];
-    snprintf(buf, sizeof(buf), "SCORE:%lu", (unsigned long)game.score);
-    lcd_draw_string(10, 10, buf, COLOR_WHITE, COLOR_BLACK);
-    
-    // Draw lines
-    snprintf(buf, sizeof(buf), "LINES:%lu", (unsigned long)game.lines_cleared);
-    lcd_draw_string(10, 25, buf, COLOR_WHITE, COLOR_BLACK);
-    
-    // Draw level
-    snprintf(buf, sizeof(buf), "LVL:%lu", (unsigned long)game.level);
-    lcd_draw_string(170, 10, buf, COLOR_WHITE, COLOR_BLACK);
+    for (int f = 0; f < HUD_FIELDS; f++) {
+        format_hud(buf, sizeof(buf), shown, f);
+        lcd_draw_string(hud_layout[f].x, hud_layout[f].y, buf, COLOR_WHITE, COLOR_BLACK);
+    }
     
     // Game state messages
-    if (game.game_over) {
+    if (shown->game_over) {
         lcd_fill_rect(40, SCREEN_HEIGHT/2 - 30, 160, 65, COLOR_BLACK);
         lcd_draw_rect(40, SCREEN_HEIGHT/2 - 30, 160, 65, COLOR_RED);
         lcd_draw_string(60, SCREEN_HEIGHT/2 - 20, "GAME OVER", COLOR_RED, COLOR_BLACK);
         lcd_draw_string(50, SCREEN_HEIGHT/2, "Press B to", COLOR_WHITE, COLOR_BLACK);
         lcd_draw_string(45, SCREEN_HEIGHT/2 + 15, "return to menu", COLOR_WHITE, COLOR_BLACK);
-    } else if (game.paused) {
+    } else if (shown->paused) {
         lcd_fill_rect(40, SCREEN_HEIGHT/2 - 30, 160, 60, COLOR_BLACK);
         lcd_draw_rect(40, SCREEN_HEIGHT/2 - 30, 160, 60, COLOR_YELLOW);
         lcd_draw_string(75, SCREEN_HEIGHT/2 - 20, "PAUSED", COLOR_YELLOW, COLOR_BLACK);
@@ -543,8 +385,31 @@ static void draw_ui(void) {
     }
 }
 
-void tetris_game_loop(void) {
+// Logic task: input and one fixed step of simulation
+static void input_step(void *arg) {
     tetris_handle_input();
+}
+
+static void update_step(float dt, void *arg) {
     tetris_update();
-    tetris_render();
+}
+
+static void snapshot_frame(void *frame, void *arg) {
+    tetris_snapshot(frame);
+}
+
+static void render_frame(const void *frame, void *arg) {
+    tetris_render(frame);
+}
+
+esp_err_t tetris_start(void) {
+    game_tasks_config_t config = {
+        .input = input_step,
+        .update = update_step,
+        .snapshot = snapshot_frame,
+        .render = render_frame,
+        .frame_size = sizeof(tetris_frame_t),
+        .tick_hz = 60,
+    };
+    return game_tasks_start(&config);
 }
@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "driver/spi_master.h"
+#include "tetris_logic.h"
 
 // Button GPIO Definitions
 #define BTN_UP     17
@@ -32,9 +33,7 @@
 #define SCREEN_WIDTH  240
 #define SCREEN_HEIGHT 320
 
-// Game dimensions
-#define BOARD_WIDTH   10
-#define BOARD_HEIGHT  20
+// Board layout on screen
 #define BLOCK_SIZE    12
 #define BOARD_OFFSET_X 60   // Center the 10-block wide board (10*12=120, (240-120)/2=60)
 #define BOARD_OFFSET_Y 40   // Leave space for score display
@@ -52,30 +51,10 @@
 #define COLOR_ORANGE   0xFD20
 #define COLOR_PURPLE   0x780F
 
-// Tetromino types
-typedef enum {
-    TETROMINO_I = 0,  // Cyan
-    TETROMINO_O = 1,  // Yellow
-    TETROMINO_T = 2,  // Purple
-    TETROMINO_S = 3,  // Green
-    TETROMINO_Z = 4,  // Red
-    TETROMINO_J = 5,  // Blue
-    TETROMINO_L = 6,  // Orange
-    TETROMINO_COUNT = 7
-} tetromino_type_t;
-
-// Tetromino piece structure
+// Snapshot of one logic tick, everything the renderer draws. The logic task
+// publishes these to the render task (see game_tasks.h).
 typedef struct {
-    tetromino_type_t type;
-    int x;
-    int y;
-    int rotation;  // 0-3
-    uint16_t color;
-} tetromino_t;
-
-// Game state
-typedef struct {
-    uint8_t board[BOARD_HEIGHT][BOARD_WIDTH];  // 0=empty, 1-7=color
+    uint8_t board[BOARD_HEIGHT][BOARD_WIDTH];
     tetromino_t current_piece;
     tetromino_t next_piece;
     uint32_t score;
@@ -83,10 +62,8 @@ typedef struct {
     uint32_t level;
     bool game_over;
     bool paused;
-    uint32_t drop_timer;
-    uint32_t drop_interval;  // Decreases with level
-    uint32_t game_tick;
-} tetris_state_t;
+    bool exiting;
+} tetris_frame_t;
 
 // Function declarations
 
@@ -97,9 +74,10 @@ typedef struct {
 esp_err_t tetris_init(void);
 
 /**
- * @brief Main game loop (call repeatedly)
+ * @brief Start the logic and render tasks (returns once they run)
+ * @return ESP_OK on success
  */
-void tetris_game_loop(void);
+esp_err_t tetris_start(void);
 
 /**
  * @brief Reset game to initial state
@@ -117,8 +95,13 @@ void tetris_handle_input(void);
 void tetris_update(void);
 
 /**
- * @brief Render the game
+ * @brief Copy what the renderer needs out of the game state
+ */
+void tetris_snapshot(tetris_frame_t *frame);
+
+/**
+ * @brief Render a snapshot
  */
-void tetris_render(void);
+void tetris_render(const tetris_frame_t *frame);
 
 #endif // TETRIS_GAME_H
@@ -0,0 +1,297 @@
+/**
+ * @file tetris_logic.c
+ * @brief Tetris rules: pieces, collision, line clears and scoring
+ */
+
+#include "tetris_logic.h"
+#include <string.h>
+
+// Shifted into place, a shape's rows collide with the board rows in a
+// single AND
+#define ROW(a, b, c, d) ((a) | (b) << 1 | (c) << 2 | (d) << 3)
+const uint8_t tetromino_shapes[TETROMINO_COUNT][4][4] = {
+    // I piece (Cyan)
+    {
+        {ROW(0,0,0,0), ROW(1,1,1,1), ROW(0,0,0,0), ROW(0,0,0,0)},
+        {ROW(0,0,1,0), ROW(0,0,1,0), ROW(0,0,1,0), ROW(0,0,1,0)},
+        {ROW(0,0,0,0), ROW(0,0,0,0), ROW(1,1,1,1), ROW(0,0,0,0)},
+        {ROW(0,1,0,0), ROW(0,1,0,0), ROW(0,1,0,0), ROW(0,1,0,0)}
+    },
+    // O piece (Yellow)
+    {
+        {ROW(0,1,1,0), ROW(0,1,1,0), ROW(0,0,0,0), ROW(0,0,0,0)},
+        {ROW(0,1,1,0), ROW(0,1,1,0), ROW(0,0,0,0), ROW(0,0,0,0)},
+        {ROW(0,1,1,0), ROW(0,1,1,0), ROW(0,0,0,0), ROW(0,0,0,0)},
+        {ROW(0,1,1,0), ROW(0,1,1,0), ROW(0,0,0,0), ROW(0,0,0,0)}
+    },
+    // T piece (Purple)
+    {
+        {ROW(0,1,0,0), ROW(1,1,1,0), ROW(0,0,0,0), ROW(0,0,0,0)},
+        {ROW(0,1,0,0), ROW(0,1,1,0), ROW(0,1,0,0), ROW(0,0,0,0)},
+        {ROW(0,0,0,0), ROW(1,1,1,0), ROW(0,1,0,0), ROW(0,0,0,0)},
+        {ROW(0,1,0,0), ROW(1,1,0,0), ROW(0,1,0,0), ROW(0,0,0,0)}
+    },
+    // S piece (Green)
+    {
+        {ROW(0,1,1,0), ROW(1,1,0,0), ROW(0,0,0,0), ROW(0,0,0,0)},
+        {ROW(0,1,0,0), ROW(0,1,1,0), ROW(0,0,1,0), ROW(0,0,0,0)},
+        {ROW(0,0,0,0), ROW(0,1,1,0), ROW(1,1,0,0), ROW(0,0,0,0)},
+        {ROW(1,0,0,0), ROW(1,1,0,0), ROW(0,1,0,0), ROW(0,0,0,0)}
+    },
+    // Z piece (Red)
+    {
+        {ROW(1,1,0,0), ROW(0,1,1,0), ROW(0,0,0,0), ROW(0,0,0,0)},
+        {ROW(0,0,1,0), ROW(0,1,1,0), ROW(0,1,0,0), ROW(0,0,0,0)},
+        {ROW(0,0,0,0), ROW(1,1,0,0), ROW(0,1,1,0), ROW(0,0,0,0)},
+        {ROW(0,1,0,0), ROW(1,1,0,0), ROW(1,0,0,0), ROW(0,0,0,0)}
+    },
+    // J piece (Blue)
+    {
+        {ROW(1,0,0,0), ROW(1,1,1,0), ROW(0,0,0,0), ROW(0,0,0,0)},
+        {ROW(0,1,1,0), ROW(0,1,0,0), ROW(0,1,0,0), ROW(0,0,0,0)},
+        {ROW(0,0,0,0), ROW(1,1,1,0), ROW(0,0,1,0), ROW(0,0,0,0)},
+        {ROW(0,1,0,0), ROW(0,1,0,0), ROW(1,1,0,0), ROW(0,0,0,0)}
+    },
+    // L piece (Orange)
+    {
+        {ROW(0,0,1,0), ROW(1,1,1,0), ROW(0,0,0,0), ROW(0,0,0,0)},
+        {ROW(0,1,0,0), ROW(0,1,0,0), ROW(0,1,1,0), ROW(0,0,0,0)},
+        {ROW(0,0,0,0), ROW(1,1,1,0), ROW(1,0,0,0), ROW(0,0,0,0)},
+        {ROW(1,1,0,0), ROW(0,1,0,0), ROW(0,1,0,0), ROW(0,0,0,0)}
+    }
+};
+
+static void spawn_piece(tetris_state_t *game, tetromino_t *piece);
+static void lock_piece(tetris_state_t *game);
+static void clear_lines(tetris_state_t *game);
+static void rotate_piece(tetris_state_t *game);
+static void move_piece(tetris_state_t *game, int dx, int dy);
+static void hard_drop(tetris_state_t *game);
+static int get_drop_interval(const tetris_state_t *game);
+
+void tetris_logic_reset(tetris_state_t *game, uint32_t seed) {
+    // Clear board
+    for (int y = 0; y < BOARD_HEIGHT + BOARD_FLOOR; y++) {
+        game->rows[y] = (y < BOARD_HEIGHT) ? BOARD_ROW_EMPTY : BOARD_ROW_FULL;
+    }
+    memset(game->board, 0, sizeof(game->board));
+
+    // Initialize game state
+    game->score = 0;
+    game->lines_cleared = 0;
+    game->level = 1;
+    game->pieces = 0;
+    game->game_over = false;
+    game->paused = false;
+    game->exiting = false;
+    game->drop_timer = 0;
+    game->drop_interval = get_drop_interval(game);
+    game->game_tick = 0;
+    game->rng = seed ? seed : 1;  // Zero would stick at zero
+
+    // Spawn first pieces
+    spawn_piece(game, &game->current_piece);
+    spawn_piece(game, &game->next_piece);
+}
+
+// xorshift32: cheap, and the whole sequence follows from the seed
+static uint32_t next_random(tetris_state_t *game) {
+    uint32_t x = game->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    game->rng = x;
+    return x;
+}
+
+static void spawn_piece(tetris_state_t *game, tetromino_t *piece) {
+    piece->type = next_random(game) % TETROMINO_COUNT;
+    piece->x = BOARD_WIDTH / 2 - 2;  // Center horizontally
+    piece->y = 0;
+    piece->rotation = 0;
+}
+
+// A piece never gets more than one column past a wall before this rejects
+// it, so its shifted rows stay inside the 16 bits
+bool tetris_logic_collides(const tetris_state_t *game, const tetromino_t *piece) {
+    const uint8_t *shape = tetromino_shapes[piece->type][piece->rotation];
+    const uint16_t *rows = &game->rows[piece->y];
+    int shift = piece->x + BOARD_WALL;
+
+    return ((rows[0] & (shape[0] << shift)) | (rows[1] & (shape[1] << shift)) |
+            (rows[2] & (shape[2] << shift)) | (rows[3] & (shape[3] << shift))) != 0;
+}
+
+static void lock_piece(tetris_state_t *game) {
+    const tetromino_t *piece = &game->current_piece;
+    const uint8_t *shape = tetromino_shapes[piece->type][piece->rotation];
+
+    // Add piece to board: occupancy in one OR per row, then its colors
+    for (int y = 0; y < 4; y++) {
+        if (shape[y] == 0) {
+            continue;
+        }
+        int board_y = piece->y + y;
+        game->rows[board_y] |= shape[y] << (piece->x + BOARD_WALL);
+        for (int x = 0; x < 4; x++) {
+            if (shape[y] & (1 << x)) {
+                game->board[board_y][piece->x + x] = piece->type + 1;
+            }
+        }
+    }
+    game->pieces++;
+
+    // Clear completed lines
+    clear_lines(game);
+
+    // Spawn next piece
+    game->current_piece = game->next_piece;
+    spawn_piece(game, &game->next_piece);
+
+    // Check game over
+    if (tetris_logic_collides(game, &game->current_piece)) {
+        game->game_over = true;
+    }
+}
+
+// One pass from the bottom: full rows are skipped and the rest slide down
+// over them
+static void clear_lines(tetris_state_t *game) {
+    int lines_cleared_now = 0;
+    int dst = BOARD_HEIGHT - 1;
+
+    for (int y = BOARD_HEIGHT - 1; y >= 0; y--) {
+        if (game->rows[y] == BOARD_ROW_FULL) {
+            lines_cleared_now++;
+            continue;
+        }
+        if (dst != y) {
+            game->rows[dst] = game->rows[y];
+            memcpy(game->board[dst], game->board[y], BOARD_WIDTH);
+        }
+        dst--;
+    }
+
+    if (lines_cleared_now > 0) {
+        // Rows left at the top are empty
+        for (; dst >= 0; dst--) {
+            game->rows[dst] = BOARD_ROW_EMPTY;
+            memset(game->board[dst], 0, BOARD_WIDTH);
+        }
+
+        // Scoring: 1 line=100, 2=300, 3=500, 4=800
+        static const uint32_t line_scores[] = {0, 100, 300, 500, 800};
+        game->score += line_scores[lines_cleared_now] * game->level;
+        game->lines_cleared += lines_cleared_now;
+
+        // Level up every 10 lines
+        game->level = game->lines_cleared / 10 + 1;
+        game->drop_interval = get_drop_interval(game);
+    }
+}
+
+static void rotate_piece(tetris_state_t *game) {
+    tetromino_t test_piece = game->current_piece;
+    test_piece.rotation = (test_piece.rotation + 1) % 4;
+
+    if (!tetris_logic_collides(game, &test_piece)) {
+        game->current_piece.rotation = test_piece.rotation;
+    }
+}
+
+static void move_piece(tetris_state_t *game, int dx, int dy) {
+    tetromino_t test_piece = game->current_piece;
+    test_piece.x += dx;
+    test_piece.y += dy;
+
+    if (!tetris_logic_collides(game, &test_piece)) {
+        game->current_piece.x = test_piece.x;
+        game->current_piece.y = test_piece.y;
+    } else if (dy > 0) {
+        // Hit bottom, lock piece
+        lock_piece(game);
+        game->drop_timer = 0;
+    }
+}
+
+static void hard_drop(tetris_state_t *game) {
+    while (true) {
+        tetromino_t test_piece = game->current_piece;
+        test_piece.y++;
+
+        if (tetris_logic_collides(game, &test_piece)) {
+            lock_piece(game);
+            game->drop_timer = 0;
+            game->score += 2;  // Bonus for hard drop
+            break;
+        }
+        game->current_piece.y++;
+    }
+}
+
+static int get_drop_interval(const tetris_state_t *game) {
+    // Drop faster as level increases (60 ticks = 1 second at 60 FPS)
+    int base = 60;
+    int reduction = (game->level - 1) * 5;
+    int interval = base - reduction;
+    return (interval < 10) ? 10 : interval;  // Minimum 10 ticks
+}
+
+void tetris_logic_input(tetris_state_t *game, uint8_t keys) {
+    if (game->exiting) return;
+
+    if (game->game_over) {
+        if (keys & TETRIS_KEY_BACK) {
+            game->exiting = true;
+        }
+        return;
+    }
+
+    if (game->paused) {
+        if (keys & TETRIS_KEY_HARD_DROP) {
+            game->paused = false;
+        }
+        if (keys & TETRIS_KEY_BACK) {
+            game->exiting = true;
+        }
+        return;
+    }
+
+    if (keys & TETRIS_KEY_ROTATE) {
+        rotate_piece(game);
+    }
+    if (keys & TETRIS_KEY_LEFT) {
+        move_piece(game, -1, 0);
+    }
+    if (keys & TETRIS_KEY_RIGHT) {
+        move_piece(game, 1, 0);
+    }
+
+    // Soft drop (move down faster)
+    if (keys & TETRIS_KEY_SOFT_DROP) {
+        move_piece(game, 0, 1);
+        game->score += 1;  // Small bonus for soft drop
+    }
+
+    if (keys & TETRIS_KEY_HARD_DROP) {
+        hard_drop(game);
+    }
+
+    // Pause game
+    if (keys & TETRIS_KEY_BACK) {
+        game->paused = true;
+    }
+}
+
+void tetris_logic_update(tetris_state_t *game) {
+    if (game->game_over || game->paused) return;
+
+    game->game_tick++;
+    game->drop_timer++;
+
+    // Auto-drop piece
+    if (game->drop_timer >= game->drop_interval) {
+        move_piece(game, 0, 1);
+        game->drop_timer = 0;
+    }
+}
@@ -0,0 +1,105 @@
+/**
+ * @file tetris_logic.h
+ * @brief Tetris rules with no hardware behind them
+ *
+ * Pieces, collision, locking, line clears, scoring and the drop timer.
+ * The state is passed in, pieces come from a generator seeded at reset and
+ * input arrives as a mask of keys, so the same code runs on the badge and
+ * in the host simulator (../host), and a seed plus the keys of each step
+ * replays a game exactly.
+ */
+
+#ifndef TETRIS_LOGIC_H
+#define TETRIS_LOGIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Game dimensions
+#define BOARD_WIDTH   10
+#define BOARD_HEIGHT  20
+
+// Occupancy rows: column x is bit x + BOARD_WALL of a 16-bit mask, the bits
+// either side of the playfield are set as walls, and BOARD_FLOOR solid rows
+// sit below it, so a piece 4 cells tall never reads past the end
+#define BOARD_WALL    3
+#define BOARD_FLOOR   4
+
+#define BOARD_ROW_EMPTY  ((uint16_t)~(((1u << BOARD_WIDTH) - 1) << BOARD_WALL))  // Walls only
+#define BOARD_ROW_FULL   0xFFFF
+
+// Tetromino types
+typedef enum {
+    TETROMINO_I = 0,  // Cyan
+    TETROMINO_O = 1,  // Yellow
+    TETROMINO_T = 2,  // Purple
+    TETROMINO_S = 3,  // Green
+    TETROMINO_Z = 4,  // Red
+    TETROMINO_J = 5,  // Blue
+    TETROMINO_L = 6,  // Orange
+    TETROMINO_COUNT = 7
+} tetromino_type_t;
+
+// Tetromino piece structure
+typedef struct {
+    tetromino_type_t type;
+    int x;
+    int y;
+    int rotation;  // 0-3
+} tetromino_t;
+
+// Game state
+typedef struct {
+    uint16_t rows[BOARD_HEIGHT + BOARD_FLOOR]; // Occupancy, walls and floor included
+    uint8_t board[BOARD_HEIGHT][BOARD_WIDTH];  // Color plane: 0=empty, 1-7=color
+    tetromino_t current_piece;
+    tetromino_t next_piece;
+    uint32_t score;
+    uint32_t lines_cleared;
+    uint32_t level;
+    uint32_t pieces;         // Pieces locked
+    bool game_over;
+    bool paused;
+    bool exiting;            // Back pressed to leave; the renderer restarts
+    uint32_t drop_timer;
+    uint32_t drop_interval;  // Decreases with level
+    uint32_t game_tick;
+    uint32_t rng;            // Piece generator, xorshift32
+} tetris_state_t;
+
+// Keys pressed since the last input step
+typedef enum {
+    TETRIS_KEY_ROTATE    = 1 << 0,
+    TETRIS_KEY_LEFT      = 1 << 1,
+    TETRIS_KEY_RIGHT     = 1 << 2,
+    TETRIS_KEY_SOFT_DROP = 1 << 3,
+    TETRIS_KEY_HARD_DROP = 1 << 4,  // Also resumes from pause
+    TETRIS_KEY_BACK      = 1 << 5,  // Pauses; when paused or over, leaves
+} tetris_key_t;
+
+// Tetromino shapes (4x4 grid, 4 rotations each), one bit mask per row with
+// the leftmost column in bit 0
+extern const uint8_t tetromino_shapes[TETROMINO_COUNT][4][4];
+
+/**
+ * @brief Start a new game; the same seed deals the same pieces
+ */
+void tetris_logic_reset(tetris_state_t *game, uint32_t seed);
+
+/**
+ * @brief Apply one step's keys, in the order rotate, left, right, soft drop,
+ * hard drop, back
+ */
+void tetris_logic_input(tetris_state_t *game, uint8_t keys);
+
+/**
+ * @brief Advance one fixed step (60 per second): the drop timer and auto-drop
+ */
+void tetris_logic_update(tetris_state_t *game);
+
+/**
+ * @brief Whether a piece overlaps the walls, floor or locked cells
+ */
+bool tetris_logic_collides(const tetris_state_t *game, const tetromino_t *piece);
+
+#endif // TETRIS_LOGIC_H
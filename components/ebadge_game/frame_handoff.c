@@ -0,0 +1,39 @@
+/**
+ * @file frame_handoff.c
+ * @brief Lock-free single-producer/single-consumer triple buffer
+ */
+
+#include "frame_handoff.h"
+
+#define FRAME_HANDOFF_FRESH 0x4
+#define FRAME_HANDOFF_SLOT  0x3
+
+void frame_handoff_init(frame_handoff_t *h, void *storage, size_t size) {
+    h->slots = storage;
+    h->size = size;
+    h->back = 0;
+    atomic_init(&h->middle, 1);
+    h->front = 2;
+}
+
+void *frame_handoff_back(frame_handoff_t *h) {
+    return h->slots + h->back * h->size;
+}
+
+void frame_handoff_publish(frame_handoff_t *h) {
+    // Release makes the frame's contents visible before its slot index
+    unsigned old = atomic_exchange_explicit(&h->middle, h->back | FRAME_HANDOFF_FRESH,
+                                            memory_order_acq_rel);
+    h->back = old & FRAME_HANDOFF_SLOT;
+}
+
+bool frame_handoff_take(frame_handoff_t *h, const void **frame) {
+    if (!(atomic_load_explicit(&h->middle, memory_order_relaxed) & FRAME_HANDOFF_FRESH)) {
+        return false;
+    }
+    // Only the producer can set the flag again, so the middle is still fresh
+    unsigned old = atomic_exchange_explicit(&h->middle, h->front, memory_order_acq_rel);
+    h->front = old & FRAME_HANDOFF_SLOT;
+    *frame = h->slots + h->front * h->size;
+    return true;
+}
@@ -0,0 +1,238 @@
+/**
+ * @file game_profile.c
+ * @brief Per-phase frame profiler with a corner overlay and a serial report
+ */
+
+#include "game_profile.h"
+#include "lcd_driver.h"
+#include "ebadge_trace.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "profile";
+
+#define PROFILE_REPORT_US    (CONFIG_EBADGE_GAME_PROFILE_REPORT_MS * 1000LL)
+#define PROFILE_OVERLAY_US   250000  // Overlay refresh; faster is unreadable
+#define PROFILE_GLYPH        (8 * CONFIG_EBADGE_LCD_FONT_SCALE)
+#define PROFILE_LINES        3
+#define PROFILE_LINE_CHARS   15      // Fits 240 pixels at font scale 2
+#define PROFILE_OVERLAY_W    (PROFILE_LINE_CHARS * PROFILE_GLYPH)
+#define PROFILE_OVERLAY_H    (PROFILE_LINES * (PROFILE_GLYPH + 2))
+#define PROFILE_OVERLAY_Y    (LCD_HEIGHT - PROFILE_OVERLAY_H)
+
+#ifdef CONFIG_EBADGE_GAME_PROFILE_OVERLAY
+#define PROFILE_OVERLAY_AT_BOOT 1
+#else
+#define PROFILE_OVERLAY_AT_BOOT 0
+#endif
+
+// Running totals over a stretch of frames, one for the report and one for
+// the overlay
+typedef struct {
+    int64_t start;
+    uint32_t frames;
+    uint64_t phase_sum[GAME_PROFILE_PHASES];
+    uint32_t phase_max[GAME_PROFILE_PHASES];
+    uint64_t bytes;
+    uint32_t transactions;
+    uint32_t worst_us;
+} profile_span_t;
+
+// Written by whichever task runs the phase, collected by game_profile_frame
+static int64_t phase_start[GAME_PROFILE_PHASES];
+static atomic_uint phase_acc[GAME_PROFILE_PHASES];
+
+static game_profile_t profile;
+static int64_t frame_end;
+static lcd_stats_t lcd_before;
+static uint8_t window[GAME_PROFILE_WINDOW];  // Histogram bucket per frame
+static unsigned window_pos, window_fill;
+static profile_span_t report, overlay;
+
+static atomic_uint overlay_on = PROFILE_OVERLAY_AT_BOOT;
+static bool overlay_drawn;
+static char overlay_text[PROFILE_LINES][32];  // Room for any value; clamped to fit
+
+// Phases also go to the trace, in the same order
+void game_profile_begin(game_profile_phase_t phase) {
+    EBADGE_TRACE_BEGIN(EBADGE_TRACE_GAME_INPUT + phase, 0);
+    phase_start[phase] = esp_timer_get_time();
+}
+
+void game_profile_end(game_profile_phase_t phase) {
+    atomic_fetch_add_explicit(&phase_acc[phase], esp_timer_get_time() - phase_start[phase],
+                              memory_order_relaxed);
+    EBADGE_TRACE_END(EBADGE_TRACE_GAME_INPUT + phase, 0);
+}
+
+static void span_add(profile_span_t *s, const game_profile_frame_t *f) {
+    s->frames++;
+    for (int p = 0; p < GAME_PROFILE_PHASES; p++) {
+        s->phase_sum[p] += f->phase_us[p];
+        if (f->phase_us[p] > s->phase_max[p]) {
+            s->phase_max[p] = f->phase_us[p];
+        }
+    }
+    s->bytes += f->spi_bytes;
+    s->transactions += f->spi_transactions;
+    if (f->frame_us > s->worst_us) {
+        s->worst_us = f->frame_us;
+    }
+}
+
+static void span_reset(profile_span_t *s, int64_t now) {
+    memset(s, 0, sizeof(*s));
+    s->start = now;
+}
+
+static uint32_t span_avg(const profile_span_t *s, int phase) {
+    return s->frames ? s->phase_sum[phase] / s->frames : 0;
+}
+
+static void log_report(int64_t now) {
+    const profile_span_t *s = &report;
+    const game_profile_frame_t *w = &profile.worst;
+
+    // Histogram buckets up to the last one in use
+    char hist[GAME_PROFILE_BUCKETS * 6 + 1];
+    int used = GAME_PROFILE_BUCKETS;
+    while (used > 0 && profile.histogram[used - 1] == 0) {
+        used--;
+    }
+    int len = 0;
+    for (int b = 0; b < used; b++) {
+        len += snprintf(hist + len, sizeof(hist) - len, " %u", profile.histogram[b]);
+    }
+    hist[len] = '\0';
+
+    uint32_t fps10 = s->frames * 10000000LL / (now - s->start);
+    ESP_LOGI(TAG, "%lu.%lu fps | in %lu/%lu up %lu/%lu rd %lu/%lu us | spi %lu B %lu tx | "
+             "worst %lu us (in %lu up %lu rd %lu) | hist/%dms%s",
+             (unsigned long)fps10 / 10, (unsigned long)fps10 % 10,
+             (unsigned long)span_avg(s, GAME_PROFILE_INPUT),
+             (unsigned long)s->phase_max[GAME_PROFILE_INPUT],
+             (unsigned long)span_avg(s, GAME_PROFILE_UPDATE),
+             (unsigned long)s->phase_max[GAME_PROFILE_UPDATE],
+             (unsigned long)span_avg(s, GAME_PROFILE_RENDER),
+             (unsigned long)s->phase_max[GAME_PROFILE_RENDER],
+             (unsigned long)(s->bytes / s->frames), (unsigned long)(s->transactions / s->frames),
+             (unsigned long)w->frame_us, (unsigned long)w->phase_us[GAME_PROFILE_INPUT],
+             (unsigned long)w->phase_us[GAME_PROFILE_UPDATE],
+             (unsigned long)w->phase_us[GAME_PROFILE_RENDER],
+             GAME_PROFILE_BUCKET_MS, hist);
+}
+
+static unsigned long clamp(uint64_t v, unsigned long max) {
+    return (v > max) ? max : (unsigned long)v;
+}
+
+// Values are clamped to their column widths so each line fits the overlay
+static void format_overlay(int64_t now) {
+    const profile_span_t *s = &overlay;
+    snprintf(overlay_text[0], sizeof(overlay_text[0]), "%3lufps w%3lums",
+             clamp(s->frames * 1000000LL / (now - s->start), 999),
+             clamp(s->worst_us / 1000, 999));
+    snprintf(overlay_text[1], sizeof(overlay_text[1]), "u%4lu r%6lu",
+             clamp(span_avg(s, GAME_PROFILE_INPUT) + span_avg(s, GAME_PROFILE_UPDATE), 9999),
+             clamp(span_avg(s, GAME_PROFILE_RENDER), 999999));
+    snprintf(overlay_text[2], sizeof(overlay_text[2]), "spi%5luB%4lut",
+             clamp(s->bytes / s->frames, 99999), clamp(s->transactions / s->frames, 9999));
+}
+
+void game_profile_frame(void) {
+    int64_t now = esp_timer_get_time();
+    lcd_stats_t lcd;
+    lcd_get_stats(&lcd);
+
+    if (frame_end == 0) {
+        // First frame: nothing to measure against yet
+        frame_end = now;
+        lcd_before = lcd;
+        span_reset(&report, now);
+        span_reset(&overlay, now);
+        for (int p = 0; p < GAME_PROFILE_PHASES; p++) {
+            atomic_store(&phase_acc[p], 0);
+        }
+        return;
+    }
+
+    game_profile_frame_t f = {
+        .frame_us = now - frame_end,
+        .spi_bytes = lcd.bytes - lcd_before.bytes,
+        .spi_transactions = lcd.transactions - lcd_before.transactions,
+    };
+    for (int p = 0; p < GAME_PROFILE_PHASES; p++) {
+        f.phase_us[p] = atomic_exchange_explicit(&phase_acc[p], 0, memory_order_relaxed);
+    }
+    frame_end = now;
+    lcd_before = lcd;
+
+    profile.last = f;
+    if (f.frame_us > profile.worst.frame_us) {
+        profile.worst = f;
+    }
+
+    // Rolling histogram: the oldest frame leaves as the newest comes in
+    uint32_t bucket = f.frame_us / (GAME_PROFILE_BUCKET_MS * 1000);
+    if (bucket >= GAME_PROFILE_BUCKETS) {
+        bucket = GAME_PROFILE_BUCKETS - 1;
+    }
+    if (window_fill == GAME_PROFILE_WINDOW) {
+        profile.histogram[window[window_pos]]--;
+    } else {
+        window_fill++;
+    }
+    window[window_pos] = bucket;
+    profile.histogram[bucket]++;
+    window_pos = (window_pos + 1) % GAME_PROFILE_WINDOW;
+
+    span_add(&report, &f);
+    span_add(&overlay, &f);
+
+    // Redraw the overlay when its numbers refresh, or once to erase it
+    bool on = atomic_load(&overlay_on);
+    if (!on) {
+        span_reset(&overlay, now);
+    } else if (now - overlay.start >= PROFILE_OVERLAY_US) {
+        format_overlay(now);
+        span_reset(&overlay, now);
+        lcd_invalidate(0, PROFILE_OVERLAY_Y, PROFILE_OVERLAY_W, PROFILE_OVERLAY_H);
+    }
+    if (on != overlay_drawn) {
+        lcd_invalidate(0, PROFILE_OVERLAY_Y, PROFILE_OVERLAY_W, PROFILE_OVERLAY_H);
+    }
+
+    if (PROFILE_REPORT_US > 0 && now - report.start >= PROFILE_REPORT_US) {
+        log_report(now);
+        span_reset(&report, now);
+        memset(&profile.worst, 0, sizeof(profile.worst));
+    }
+}
+
+void game_profile_get(game_profile_t *out) {
+    *out = profile;
+}
+
+void game_profile_toggle_overlay(void) {
+    atomic_fetch_xor(&overlay_on, 1);
+}
+
+bool game_profile_overlay_enabled(void) {
+    return atomic_load(&overlay_on);
+}
+
+void game_profile_draw_overlay(void) {
+    overlay_drawn = atomic_load(&overlay_on);
+    if (!overlay_drawn || overlay_text[0][0] == '\0') {
+        return;
+    }
+    lcd_fill_rect(0, PROFILE_OVERLAY_Y, PROFILE_OVERLAY_W, PROFILE_OVERLAY_H, 0x0000);
+    for (int i = 0; i < PROFILE_LINES; i++) {
+        lcd_draw_string(0, PROFILE_OVERLAY_Y + 1 + i * (PROFILE_GLYPH + 2),
+                        overlay_text[i], 0xFFFF, 0x0000);
+    }
+}
@@ -0,0 +1,150 @@
+/**
+ * @file game_tasks.c
+ * @brief Fixed-step logic task and a render task on separate cores
+ */
+
+#include "game_tasks.h"
+#include "frame_handoff.h"
+#include "game_profile.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "game_tasks";
+
+#define GAME_LOGIC_STACK   4096
+#define GAME_RENDER_STACK  4096
+#define GAME_TASK_PRIORITY 5
+
+static game_tasks_config_t config;
+static frame_handoff_t handoff;
+static TaskHandle_t render_task;
+static game_tasks_stats_t stats;
+
+static void logic_task(void *param) {
+    const int64_t step_us = 1000000 / config.tick_hz;
+    const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+    const float dt = (float)step_us / 1000000.0f;
+    
+    // The first wake-up runs one step straight away
+    int64_t last = esp_timer_get_time();
+    int64_t last_publish = last;
+    int64_t pending = step_us;
+    TickType_t wake = xTaskGetTickCount();
+    
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        pending += now - last;
+        last = now;
+        
+        int steps = 0;
+        while (pending >= step_us && steps < GAME_TASKS_MAX_CATCHUP) {
+            if (config.input != NULL) {
+                game_profile_begin(GAME_PROFILE_INPUT);
+                config.input(config.arg);
+                game_profile_end(GAME_PROFILE_INPUT);
+            }
+            game_profile_begin(GAME_PROFILE_UPDATE);
+            config.update(dt, config.arg);
+            game_profile_end(GAME_PROFILE_UPDATE);
+            pending -= step_us;
+            steps++;
+        }
+        if (pending >= step_us) {
+            stats.dropped += pending / step_us;
+            pending %= step_us;
+        }
+        
+        if (steps > 0) {
+            game_profile_begin(GAME_PROFILE_UPDATE);
+            config.snapshot(frame_handoff_back(&handoff), config.arg);
+            game_profile_end(GAME_PROFILE_UPDATE);
+            frame_handoff_publish(&handoff);
+            xTaskNotifyGive(render_task);
+            
+            stats.steps += steps;
+            stats.published++;
+            if (steps > 1) {
+                stats.catchups++;
+            }
+            stats.frame_us = now - last_publish;
+            stats.update_us = esp_timer_get_time() - now;
+            last_publish = now;
+        }
+        
+        // Sleep until the next step is due. The current tick is already
+        // partly over, so one more is added to avoid waking early to find
+        // nothing to do. The deadline is kept against `wake` so preemption
+        // before the call does not push it back; sleeping at least one tick
+        // lets the idle task run.
+        int64_t due = step_us - pending - (esp_timer_get_time() - last);
+        TickType_t ticks = (due > 0) ? (due + tick_us - 1) / tick_us + 1 : 1;
+        vTaskDelayUntil(&wake, (xTaskGetTickCount() - wake) + ticks);
+    }
+}
+
+static void render_task_fn(void *param) {
+    const uint32_t budget_us = config.render_budget_us ? config.render_budget_us
+                                                       : 1000000 / config.tick_hz;
+    while (1) {
+        // Woken once per publish; a burst of publishes leaves one wake-up
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        const void *frame;
+        if (!frame_handoff_take(&handoff, &frame)) {
+            continue;
+        }
+        
+        int64_t start = esp_timer_get_time();
+        game_profile_begin(GAME_PROFILE_RENDER);
+        config.render(frame, config.arg);
+        game_profile_end(GAME_PROFILE_RENDER);
+        uint32_t us = esp_timer_get_time() - start;
+        game_profile_frame();
+        
+        stats.rendered++;
+        stats.render_us = us;
+        if (us > stats.render_max_us) {
+            stats.render_max_us = us;
+        }
+        if (us > budget_us) {
+            stats.over_budget++;
+        }
+    }
+}
+
+esp_err_t game_tasks_start(const game_tasks_config_t *cfg) {
+    if (cfg->update == NULL || cfg->snapshot == NULL || cfg->render == NULL ||
+        cfg->frame_size == 0 || cfg->tick_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    config = *cfg;
+    
+    void *storage = heap_caps_calloc(3, cfg->frame_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (storage == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate 3 x %u byte frames", (unsigned)cfg->frame_size);
+        return ESP_ERR_NO_MEM;
+    }
+    frame_handoff_init(&handoff, storage, cfg->frame_size);
+    
+    // The render task stays on this core, which owns the SPI interrupt
+    BaseType_t render_core = xPortGetCoreID();
+    BaseType_t logic_core = (portNUM_PROCESSORS > 1) ? !render_core : render_core;
+    if (xTaskCreatePinnedToCore(render_task_fn, "game_render", GAME_RENDER_STACK, NULL,
+                                GAME_TASK_PRIORITY, &render_task, render_core) != pdPASS ||
+        xTaskCreatePinnedToCore(logic_task, "game_logic", GAME_LOGIC_STACK, NULL,
+                                GAME_TASK_PRIORITY, NULL, logic_core) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create game tasks");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    ESP_LOGI(TAG, "Logic on core %d at %lu Hz, render on core %d, %u byte frames",
+             (int)logic_core, (unsigned long)cfg->tick_hz, (int)render_core,
+             (unsigned)cfg->frame_size);
+    return ESP_OK;
+}
+
+void game_tasks_get_stats(game_tasks_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file frame_handoff.h
+ * @brief Lock-free single-producer/single-consumer triple buffer
+ */
+
+#ifndef FRAME_HANDOFF_H
+#define FRAME_HANDOFF_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Three frame slots: the producer owns one, the consumer owns one and the
+// third sits in the middle holding the latest published frame. Publishing
+// and taking each swap a slot with the middle in one atomic exchange, so
+// neither side ever waits for the other or sees a half-written frame. A
+// consumer that falls behind skips straight to the newest frame.
+typedef struct {
+    uint8_t *slots;        // Three frames of `size` bytes
+    size_t size;
+    atomic_uint middle;    // Slot index, plus FRAME_HANDOFF_FRESH until taken
+    unsigned back;         // Producer's slot
+    unsigned front;        // Consumer's slot
+} frame_handoff_t;
+
+// storage holds 3 * size bytes
+void frame_handoff_init(frame_handoff_t *h, void *storage, size_t size);
+
+// Producer: the slot to fill, then hand it over. The slot still holds an
+// older frame, so every field has to be written before publishing.
+void *frame_handoff_back(frame_handoff_t *h);
+void frame_handoff_publish(frame_handoff_t *h);
+
+// Consumer: point *frame at the newest published frame. Returns false, and
+// leaves *frame alone, if nothing was published since the last take.
+bool frame_handoff_take(frame_handoff_t *h, const void **frame);
+
+#endif // FRAME_HANDOFF_H
@@ -0,0 +1,62 @@
+/**
+ * @file game_profile.h
+ * @brief Per-phase frame profiler with a corner overlay and a serial report
+ */
+
+#ifndef GAME_PROFILE_H
+#define GAME_PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Each frame is split into phases timed with begin/end pairs. A phase can
+// run several times per frame, as catch-up steps do, and its times add up.
+// game_profile_frame closes the frame after its lcd_flush and picks up the
+// SPI traffic from the LCD counters. game_tasks does all of this by itself;
+// a hand-written loop calls the functions directly.
+//
+// Every CONFIG_EBADGE_GAME_PROFILE_REPORT_MS a one-line summary goes to the
+// log. The overlay shows the same numbers in the bottom-left corner, a few
+// times a second.
+
+typedef enum {
+    GAME_PROFILE_INPUT,
+    GAME_PROFILE_UPDATE,
+    GAME_PROFILE_RENDER,
+    GAME_PROFILE_PHASES
+} game_profile_phase_t;
+
+#define GAME_PROFILE_WINDOW    128  // Frames in the rolling histogram
+#define GAME_PROFILE_BUCKETS   16
+#define GAME_PROFILE_BUCKET_MS 4    // The last bucket takes everything longer
+
+typedef struct {
+    uint32_t frame_us;                        // Since the previous frame ended
+    uint32_t phase_us[GAME_PROFILE_PHASES];
+    uint32_t spi_bytes;
+    uint32_t spi_transactions;
+} game_profile_frame_t;
+
+typedef struct {
+    game_profile_frame_t last;
+    game_profile_frame_t worst;               // Longest since the last report
+    uint16_t histogram[GAME_PROFILE_BUCKETS]; // Frame times, last WINDOW frames
+} game_profile_t;
+
+// Phases may be timed from different tasks, but each phase from one only
+void game_profile_begin(game_profile_phase_t phase);
+void game_profile_end(game_profile_phase_t phase);
+
+// End of a frame, once its lcd_flush has returned. Call from the task that
+// draws: it invalidates the overlay for the next flush when that changes.
+void game_profile_frame(void);
+
+void game_profile_get(game_profile_t *out);
+
+// The overlay is drawn by the render callback calling game_profile_draw_overlay
+// last. The toggle may come from any task.
+void game_profile_toggle_overlay(void);
+bool game_profile_overlay_enabled(void);
+void game_profile_draw_overlay(void);
+
+#endif // GAME_PROFILE_H
@@ -0,0 +1,79 @@
+/**
+ * @file game_tasks.h
+ * @brief Fixed-step logic task and a render task on separate cores
+ */
+
+#ifndef GAME_TASKS_H
+#define GAME_TASKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// The logic task reads input, advances the game and describes the result
+// in a frame snapshot. Snapshots reach the render task through a triple
+// buffer (frame_handoff.h), so the simulation of one tick overlaps the SPI
+// output of the previous one. The render task draws only the newest
+// snapshot and skips any it was too slow for.
+//
+// Updates run at a fixed rate measured with esp_timer, whatever rendering
+// costs. A late wake-up runs the missed steps back to back, up to
+// GAME_TASKS_MAX_CATCHUP, and drops the rest so a long stall does not turn
+// into a burst of fast motion. One snapshot is published per wake-up.
+//
+// Rendering stays on the core that calls game_tasks_start, which should be
+// the one that ran lcd_init since the SPI interrupt lives there; the logic
+// task takes the other core. Once the tasks run, all lcd_* calls must come
+// from the render callback.
+//
+// Input, update and render are timed by the frame profiler (game_profile.h);
+// the scene callback draws its overlay by calling game_profile_draw_overlay.
+
+#define GAME_TASKS_MAX_CATCHUP 4
+
+// Read the buttons, once before each update step
+typedef void (*game_input_fn_t)(void *arg);
+
+// One fixed step of simulation; dt is the step length in seconds
+typedef void (*game_update_fn_t)(float dt, void *arg);
+
+// Fill `frame` (frame_size bytes) with everything the renderer needs. Every
+// field must be written: the buffer holds an older snapshot.
+typedef void (*game_snapshot_fn_t)(void *frame, void *arg);
+
+// Draw a snapshot. It stays untouched until the call returns.
+typedef void (*game_render_fn_t)(const void *frame, void *arg);
+
+typedef struct {
+    game_input_fn_t input;      // Optional
+    game_update_fn_t update;
+    game_snapshot_fn_t snapshot;
+    game_render_fn_t render;
+    void *arg;                  // Passed to all callbacks
+    size_t frame_size;
+    uint32_t tick_hz;           // Fixed update rate
+    uint32_t render_budget_us;  // Renders over this are counted; 0 = one step
+} game_tasks_config_t;
+
+// Counters since game_tasks_start. Times are measured, not nominal.
+typedef struct {
+    uint32_t steps;             // Fixed updates run
+    uint32_t published;         // Snapshots handed to the renderer
+    uint32_t rendered;          // Snapshots drawn; the rest were superseded
+    uint32_t catchups;          // Wake-ups that ran more than one step
+    uint32_t dropped;           // Steps skipped past the catch-up limit
+    uint32_t over_budget;       // Renders longer than render_budget_us
+    uint32_t frame_us;          // Time between the last two publishes
+    uint32_t update_us;         // Last wake-up's update and snapshot time
+    uint32_t render_us;         // Last render time
+    uint32_t render_max_us;
+} game_tasks_stats_t;
+
+// Start both tasks. The callbacks run until the device restarts.
+esp_err_t game_tasks_start(const game_tasks_config_t *config);
+
+// Copy the counters. Either task may be mid-update, so fields can be one
+// frame apart.
+void game_tasks_get_stats(game_tasks_stats_t *stats);
+
+#endif // GAME_TASKS_H
@@ -0,0 +1,258 @@
+/**
+ * @file ebadge_input.c
+ * @brief Interrupt-driven button driver with a timestamped event queue
+ */
+
+#include "ebadge_input.h"
+#include "input_debounce.h"
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "freertos/FreeRTOS.h"
+#include "soc/gpio_reg.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include <stdatomic.h>
+
+static const char *TAG = "input";
+
+#define INPUT_DEBOUNCE_US  (CONFIG_EBADGE_INPUT_DEBOUNCE_MS * 1000)
+#define INPUT_RING         32  // Events; a power of two
+#define INPUT_ALL          ((1u << EBADGE_BUTTON_COUNT) - 1)
+
+_Static_assert((INPUT_RING & (INPUT_RING - 1)) == 0, "input ring size must be a power of two");
+
+static int pins[EBADGE_BUTTON_COUNT];
+static uint8_t stable;  // Debounced state, 1 = down
+
+// Filled by whoever settles buttons, emptied by the task that drains
+static ebadge_input_event_t ring[INPUT_RING];
+static atomic_uint ring_head, ring_tail;
+static atomic_uint overflows;
+static atomic_uint held;
+
+// Every button from one read of each input register, 1 = down
+static uint8_t read_buttons(void) {
+    uint64_t levels = REG_READ(GPIO_IN_REG) | (uint64_t)REG_READ(GPIO_IN1_REG) << 32;
+    uint8_t up = 0;
+    for (int b = 0; b < EBADGE_BUTTON_COUNT; b++) {
+        up |= ((levels >> pins[b]) & 1) << b;
+    }
+    return ~up & INPUT_ALL;
+}
+
+static void push_event(int button, bool pressed, int64_t time_us) {
+    unsigned head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&ring_tail, memory_order_acquire) == INPUT_RING) {
+        atomic_fetch_add_explicit(&overflows, 1, memory_order_relaxed);
+        return;
+    }
+    ring[head % INPUT_RING] = (ebadge_input_event_t){
+        .time_us = time_us,
+        .button = button,
+        .pressed = pressed,
+    };
+    atomic_store_explicit(&ring_head, head + 1, memory_order_release);
+}
+
+#if CONFIG_EBADGE_INPUT_POLLED
+
+static input_debounce_t debounce;
+
+// Sampling happens in the task that drains, so the ring has one thread on
+// both ends
+static void sample_buttons(void) {
+    uint8_t changes = input_debounce_step(&debounce, &stable, read_buttons());
+    if (changes == 0) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    for (int b = 0; b < EBADGE_BUTTON_COUNT; b++) {
+        if (changes & EBADGE_BUTTON_BIT(b)) {
+            push_event(b, stable & EBADGE_BUTTON_BIT(b), now);
+        }
+    }
+    atomic_store_explicit(&held, stable, memory_order_relaxed);
+}
+
+#else
+
+static gptimer_handle_t timer;  // Free-running at 1 MHz; only its alarm is used
+
+// Shared by the edge and alarm interrupts, under lock
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t bouncing;                           // Edges seen, not yet settled
+static int64_t first_edge[EBADGE_BUTTON_COUNT];    // Start of the current burst
+static int64_t last_edge[EBADGE_BUTTON_COUNT];
+static bool alarm_armed;
+
+static void arm_alarm(uint32_t delay_us) {
+    uint64_t count;
+    gptimer_get_raw_count(timer, &count);
+    gptimer_alarm_config_t alarm = {
+        .alarm_count = count + delay_us,
+    };
+    gptimer_set_alarm_action(timer, &alarm);
+}
+
+// Any edge restarts the button's quiet period
+static void edge_isr(void *arg) {
+    int b = (uintptr_t)arg;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&lock);
+    if (!(bouncing & EBADGE_BUTTON_BIT(b))) {
+        bouncing |= EBADGE_BUTTON_BIT(b);
+        first_edge[b] = now;
+    }
+    last_edge[b] = now;
+    if (!alarm_armed) {
+        alarm_armed = true;
+        arm_alarm(INPUT_DEBOUNCE_US);
+    }
+    portEXIT_CRITICAL_ISR(&lock);
+}
+
+// Settle the buttons that have been quiet long enough, then wait for the
+// next one due. A burst that ends where it started gives no event.
+static bool alarm_isr(gptimer_handle_t t, const gptimer_alarm_event_data_t *edata, void *arg) {
+    int64_t now = esp_timer_get_time();
+    int64_t next = INPUT_DEBOUNCE_US;
+    uint8_t down = read_buttons();
+
+    portENTER_CRITICAL_ISR(&lock);
+    for (int b = 0; b < EBADGE_BUTTON_COUNT; b++) {
+        uint8_t bit = EBADGE_BUTTON_BIT(b);
+        if (!(bouncing & bit)) {
+            continue;
+        }
+        int64_t quiet = now - last_edge[b];
+        if (quiet < INPUT_DEBOUNCE_US) {
+            if (INPUT_DEBOUNCE_US - quiet < next) {
+                next = INPUT_DEBOUNCE_US - quiet;
+            }
+            continue;
+        }
+        bouncing &= ~bit;
+        if ((down ^ stable) & bit) {
+            stable ^= bit;
+            push_event(b, down & bit, first_edge[b]);
+        }
+    }
+    atomic_store_explicit(&held, stable, memory_order_relaxed);
+    alarm_armed = (bouncing != 0);
+    if (alarm_armed) {
+        arm_alarm(next);
+    }
+    portEXIT_CRITICAL_ISR(&lock);
+    return false;
+}
+
+static esp_err_t start_interrupts(void) {
+    gptimer_config_t timer_conf = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,
+    };
+    esp_err_t err = gptimer_new_timer(&timer_conf, &timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No free timer for debouncing: %s", esp_err_to_name(err));
+        return err;
+    }
+    gptimer_event_callbacks_t callbacks = {
+        .on_alarm = alarm_isr,
+    };
+    ESP_ERROR_CHECK(gptimer_register_event_callbacks(timer, &callbacks, NULL));
+    ESP_ERROR_CHECK(gptimer_enable(timer));
+    ESP_ERROR_CHECK(gptimer_start(timer));
+
+    // Another component may have installed the shared handler already
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "GPIO interrupt service failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    for (int b = 0; b < EBADGE_BUTTON_COUNT; b++) {
+        ESP_ERROR_CHECK(gpio_isr_handler_add(pins[b], edge_isr, (void *)(uintptr_t)b));
+    }
+
+    ESP_LOGI(TAG, "Buttons ready, %d ms debounce", CONFIG_EBADGE_INPUT_DEBOUNCE_MS);
+    return ESP_OK;
+}
+
+#endif
+
+esp_err_t ebadge_input_init(const ebadge_input_config_t *config) {
+    uint64_t mask = 0;
+    for (int b = 0; b < EBADGE_BUTTON_COUNT; b++) {
+        pins[b] = config->gpio[b];
+        mask |= 1ULL << pins[b];
+    }
+    gpio_config_t io_conf = {
+        .pin_bit_mask = mask,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+#if CONFIG_EBADGE_INPUT_POLLED
+        .intr_type = GPIO_INTR_DISABLE,
+#else
+        .intr_type = GPIO_INTR_ANYEDGE,
+#endif
+    };
+    ESP_ERROR_CHECK(gpio_config(&io_conf));
+
+    // Starting state, before anything is debounced
+    stable = read_buttons();
+    atomic_store(&held, stable);
+
+#if CONFIG_EBADGE_INPUT_POLLED
+    ESP_LOGI(TAG, "Buttons ready, polled once per frame");
+    return ESP_OK;
+#else
+    return start_interrupts();
+#endif
+}
+
+size_t ebadge_input_drain(ebadge_input_event_t *events, size_t max) {
+#if CONFIG_EBADGE_INPUT_POLLED
+    sample_buttons();
+#endif
+    unsigned tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring_head, memory_order_acquire);
+    size_t n = 0;
+    while (tail != head && n < max) {
+        events[n++] = ring[tail % INPUT_RING];
+        tail++;
+    }
+    atomic_store_explicit(&ring_tail, tail, memory_order_release);
+    return n;
+}
+
+void ebadge_input_frame(ebadge_input_frame_t *frame) {
+#if CONFIG_EBADGE_INPUT_POLLED
+    // No events to walk: the edges fall out of the counters directly
+    uint8_t changes = input_debounce_step(&debounce, &stable, read_buttons());
+    frame->pressed = input_debounce_pressed(changes, stable);
+    frame->released = input_debounce_released(changes, stable);
+    frame->held = stable;
+    atomic_store_explicit(&held, stable, memory_order_relaxed);
+#else
+    ebadge_input_event_t events[INPUT_RING];
+    size_t n = ebadge_input_drain(events, INPUT_RING);
+
+    frame->pressed = 0;
+    frame->released = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (events[i].pressed) {
+            frame->pressed |= EBADGE_BUTTON_BIT(events[i].button);
+        } else {
+            frame->released |= EBADGE_BUTTON_BIT(events[i].button);
+        }
+    }
+    frame->held = atomic_load_explicit(&held, memory_order_relaxed);
+#endif
+}
+
+uint32_t ebadge_input_overflows(void) {
+    return atomic_load_explicit(&overflows, memory_order_relaxed);
+}
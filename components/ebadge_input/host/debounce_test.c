@@ -0,0 +1,165 @@
+/**
+ * @file debounce_test.c
+ * @brief Synthetic bounce patterns through the polled-mode debounce
+ *
+ * A pattern is one character per sample for a single button: 1 = down,
+ * 0 = up. The expected string has one character per sample too: P where
+ * the step reports a press, R where it reports a release, . otherwise.
+ * Spaces in either are ignored and only group the samples for reading.
+ */
+
+#include "input_debounce.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures;
+
+// Feed one button's samples to bit `bit`, with the other bits held at
+// `others`, and compare the reported edges
+static void check_pattern(const char *name, int bit, uint8_t others, bool held,
+                          const char *samples, const char *expect) {
+    input_debounce_t d = {0};
+    uint8_t mask = 1u << bit;
+    uint8_t stable = (held ? mask : 0) | (others & ~mask);
+    char got[256];
+    size_t n = 0;
+
+    for (const char *s = samples; *s; s++) {
+        if (*s == ' ') {
+            continue;
+        }
+        uint8_t sample = (others & ~mask) | ((*s == '1') ? mask : 0);
+        uint8_t changes = input_debounce_step(&d, &stable, sample);
+        if (changes & ~mask) {
+            printf("FAIL %s: other buttons changed (%02x)\n", name, changes & ~mask);
+            failures++;
+            return;
+        }
+        if (input_debounce_pressed(changes, stable) & mask) {
+            got[n++] = 'P';
+        } else if (input_debounce_released(changes, stable) & mask) {
+            got[n++] = 'R';
+        } else {
+            got[n++] = '.';
+        }
+    }
+    got[n] = '\0';
+
+    char want[256];
+    size_t m = 0;
+    for (const char *e = expect; *e; e++) {
+        if (*e != ' ') {
+            want[m++] = *e;
+        }
+    }
+    want[m] = '\0';
+
+    if (strcmp(got, want) != 0) {
+        printf("FAIL %s (bit %d)\n  samples %s\n  want    %s\n  got     %s\n",
+               name, bit, samples, want, got);
+        failures++;
+    }
+}
+
+// The same pattern on every button, with every other button either up or
+// down, so no case depends on which bit it runs in or on its neighbours
+static void check(const char *name, bool held, const char *samples, const char *expect) {
+    for (int bit = 0; bit < 8; bit++) {
+        check_pattern(name, bit, 0x00, held, samples, expect);
+        check_pattern(name, bit, 0xFF, held, samples, expect);
+    }
+}
+
+// Per-button model: count samples in a row that disagree, flip on the fourth
+typedef struct {
+    uint8_t count[8];
+    uint8_t stable;
+} model_t;
+
+static uint8_t model_step(model_t *m, uint8_t sample) {
+    uint8_t changes = 0;
+    for (int b = 0; b < 8; b++) {
+        uint8_t bit = 1u << b;
+        if ((sample ^ m->stable) & bit) {
+            if (++m->count[b] == 4) {
+                m->count[b] = 0;
+                m->stable ^= bit;
+                changes |= bit;
+            }
+        } else {
+            m->count[b] = 0;
+        }
+    }
+    return changes;
+}
+
+// Every button bouncing on its own random schedule: each must match the
+// model exactly, whatever the others are doing
+static void check_independent(void) {
+    input_debounce_t d = {0};
+    uint8_t stable = 0;
+    model_t model = {0};
+    uint8_t level = 0;
+    uint32_t rng = 1;
+
+    for (int step = 0; step < 200000; step++) {
+        // xorshift32; each button has its own chance of changing level
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        for (int b = 0; b < 8; b++) {
+            if (((rng >> (b * 4)) & 0xF) < (unsigned)(b + 1)) {
+                level ^= 1u << b;
+            }
+        }
+        uint8_t changes = input_debounce_step(&d, &stable, level);
+        uint8_t expect = model_step(&model, level);
+        if (changes != expect || stable != model.stable) {
+            printf("FAIL independent buttons, step %d: changes %02x state %02x, "
+                   "model %02x state %02x\n", step, changes, stable, expect, model.stable);
+            failures++;
+            return;
+        }
+    }
+}
+
+int main(void) {
+    // Clean edges need four agreeing samples
+    check("press", false, "1111 1111", "...P ....");
+    check("release", true, "0000 0000", "...R ....");
+    check("press and release", false, "1111 0000", "...P ...R");
+    check("three is not enough", false, "111 0 111 0 111", "... . ... . ...");
+
+    // Contact bounce of one to three samples before the press settles
+    check("press bounce 1", false, "10 10 10 1111", "..  ..  ..  ...P");
+    check("press bounce 2", false, "110 110 1111", "... ... ...P");
+    check("press bounce 3", false, "1110 1110 1111", ".... .... ...P");
+    check("press bounce mixed", false, "10 110 1110 1 0 1111", ".. ... .... . . ...P");
+
+    // The same on release
+    check("release bounce 1", true, "01 01 01 0000", "..  ..  ..  ...R");
+    check("release bounce 2", true, "001 001 0000", "... ... ...R");
+    check("release bounce 3", true, "0001 0001 0000", ".... .... ...R");
+    check("release bounce mixed", true, "01 001 0001 0 1 0000", ".. ... .... . . ...R");
+
+    // Single-sample glitches on a held button, and on a released one
+    check("held glitch", true, "1110 1111 0111 1101 0101 0101 1111",
+                               ".... .... .... .... .... .... ....");
+    check("released glitch", false, "0001 0000 1000 0010 1010 1010 0000",
+                                    ".... .... .... .... .... .... ....");
+
+    // A glitch right after a change does not undo it
+    check("glitch after press", false, "1111 0 1111", "...P . ....");
+    check("glitch after release", true, "0000 1 0000", "...R . ....");
+
+    check_independent();
+
+    if (failures) {
+        printf("%d failed\n", failures);
+        return 1;
+    }
+    printf("debounce: all passed\n");
+    return 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file ebadge_input.h
+ * @brief Interrupt-driven button driver with a timestamped event queue
+ */
+
+#ifndef EBADGE_INPUT_H
+#define EBADGE_INPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Every button edge raises a GPIO interrupt. A button counts as settled once
+// its pin has been quiet for CONFIG_EBADGE_INPUT_DEBOUNCE_MS, which a
+// one-shot hardware timer alarm checks; a settled change becomes a press or
+// release event in a lock-free ring. The event carries the time of the
+// first edge, so a tap shorter than a frame is still seen, in order, by
+// whoever drains the ring next. Buttons are active low with pull-ups.
+//
+// With CONFIG_EBADGE_INPUT_POLLED there are no interrupts: each
+// ebadge_input_frame call reads GPIO_IN and GPIO_IN1 once and steps a
+// vertical counter for all buttons together, so a change counts after
+// four agreeing calls. Draining instead queues the changes as events,
+// timestamped when seen.
+
+typedef enum {
+    EBADGE_BUTTON_UP,
+    EBADGE_BUTTON_DOWN,
+    EBADGE_BUTTON_LEFT,
+    EBADGE_BUTTON_RIGHT,
+    EBADGE_BUTTON_A,
+    EBADGE_BUTTON_B,
+    EBADGE_BUTTON_COUNT
+} ebadge_button_t;
+
+#define EBADGE_BUTTON_BIT(b) (1u << (b))
+
+typedef struct {
+    int64_t time_us;  // esp_timer time of the first edge
+    uint8_t button;   // ebadge_button_t
+    bool pressed;     // false for a release
+} ebadge_input_event_t;
+
+// Buttons as bitmasks of EBADGE_BUTTON_BIT
+typedef struct {
+    uint8_t pressed;   // Pressed since the last drain
+    uint8_t released;  // Released since the last drain
+    uint8_t held;      // Down now
+} ebadge_input_frame_t;
+
+typedef struct {
+    int gpio[EBADGE_BUTTON_COUNT];  // Pin for each button
+} ebadge_input_config_t;
+
+// Configure the pins and start listening. The interrupts land on the
+// calling core. The state at init counts as the starting point, so a
+// button held during boot gives no press.
+esp_err_t ebadge_input_init(const ebadge_input_config_t *config);
+
+// Take up to max queued events, oldest first. One task drains.
+size_t ebadge_input_drain(ebadge_input_event_t *events, size_t max);
+
+// Drain everything into per-frame masks; call once per frame
+void ebadge_input_frame(ebadge_input_frame_t *frame);
+
+static inline bool ebadge_input_pressed(const ebadge_input_frame_t *frame, ebadge_button_t button) {
+    return frame->pressed & EBADGE_BUTTON_BIT(button);
+}
+
+// Events dropped because the ring was full
+uint32_t ebadge_input_overflows(void);
+
+#endif // EBADGE_INPUT_H
@@ -0,0 +1,41 @@
+/**
+ * @file input_debounce.h
+ * @brief Vertical-counter debounce for all buttons at once
+ *
+ * Plain bit operations with no hardware behind them, so the polled mode's
+ * filter builds on the host as well (see host/).
+ */
+
+#ifndef INPUT_DEBOUNCE_H
+#define INPUT_DEBOUNCE_H
+
+#include <stdint.h>
+
+// Two-bit vertical counters, one bit of each per button
+typedef struct {
+    uint8_t count0, count1;
+} input_debounce_t;
+
+// Step every button's counter with one sample (1 = down) against the
+// debounced state. A button's state flips after four samples in a row that
+// disagree with it; a sample that agrees clears its count. Returns the
+// buttons that flipped.
+static inline uint8_t input_debounce_step(input_debounce_t *d, uint8_t *stable, uint8_t sample) {
+    uint8_t delta = sample ^ *stable;
+    d->count1 = (d->count1 ^ d->count0) & delta;
+    d->count0 = ~d->count0 & delta;
+    uint8_t changes = delta & ~(d->count0 | d->count1);
+    *stable ^= changes;
+    return changes;
+}
+
+// Edges from one step's changes and the state after it
+static inline uint8_t input_debounce_pressed(uint8_t changes, uint8_t stable) {
+    return changes & stable;
+}
+
+static inline uint8_t input_debounce_released(uint8_t changes, uint8_t stable) {
+    return changes & ~stable;
+}
+
+#endif // INPUT_DEBOUNCE_H
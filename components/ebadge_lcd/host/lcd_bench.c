@@ -0,0 +1,317 @@
+/**
+ * @file lcd_bench.c
+ * @brief Runs typical drawing workloads through the LCD driver on the host
+ *
+ * Prints SPI traffic per scenario and writes a PPM snapshot of each one.
+ * With -g, snapshots are compared against a directory of golden images and
+ * the exit status reports any mismatch.
+ *
+ *   lcd_bench [-o out_dir] [-g golden_dir]
+ */
+
+#include "lcd_driver.h"
+#include "lcd_tilemap.h"
+#include "lcd_sim.h"
+#include "bench_sprites.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define COLOR_BLACK   0x0000
+#define COLOR_WHITE   0xFFFF
+#define COLOR_RED     0xF800
+#define COLOR_GREEN   0x07E0
+#define COLOR_BLUE    0x001F
+#define COLOR_YELLOW  0xFFE0
+#define COLOR_CYAN    0x07FF
+#define COLOR_WALL    0x1084
+
+typedef struct {
+    const char *name;
+    void (*setup)(void);  // Optional, not counted
+    void (*run)(void);
+} scenario_t;
+
+// Fixed LCG so every run draws the same thing
+static uint32_t rng_state;
+
+static uint32_t rng(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static void run_fill_screen(void) {
+    lcd_fill_screen(COLOR_BLUE);
+}
+
+static void run_fill_rects(void) {
+    for (int i = 0; i < 200; i++) {
+        lcd_fill_rect(rng() % LCD_WIDTH, rng() % LCD_HEIGHT, 1 + rng() % 60, 1 + rng() % 60, rng());
+    }
+}
+
+static void run_text(void) {
+    char buf[24];
+    for (int line = 0; line < 12; line++) {
+        snprintf(buf, sizeof(buf), "SCORE %06d", line * 1234);
+        lcd_draw_string(4, 4 + line * 24, buf, COLOR_WHITE, COLOR_BLACK);
+    }
+}
+
+static void run_shapes(void) {
+    // A maze's worth of dots and pellets plus a few outlined sprites
+    for (int ty = 0; ty < 24; ty++) {
+        for (int tx = 0; tx < 20; tx++) {
+            lcd_fill_circle(tx * 12 + 6, 30 + ty * 12 + 6, (tx + ty) % 7 ? 2 : 4, COLOR_WHITE);
+        }
+    }
+    for (int i = 0; i < 8; i++) {
+        lcd_draw_rect(10 + i * 28, 10, 24, 14, COLOR_CYAN);
+        lcd_draw_circle(22 + i * 28, 300, 10, COLOR_YELLOW);
+    }
+}
+
+// A game-like scene for the strip renderer
+static int sprite_x;
+
+static void scene(void *arg) {
+    for (int y = 30; y < LCD_HEIGHT; y += 24) {
+        lcd_fill_rect(0, y, LCD_WIDTH, 4, COLOR_WALL);
+    }
+    for (int i = 0; i < 4; i++) {
+        lcd_fill_circle(sprite_x + i * 50, 100 + i * 40, 5, COLOR_RED + i * 0x0100);
+    }
+    lcd_draw_string(4, 4, "SCORE 001230", COLOR_WHITE, COLOR_BLACK);
+}
+
+static void setup_scene(void) {
+    sprite_x = 20;
+    lcd_set_renderer(scene, NULL);
+}
+
+static void run_strip_full(void) {
+    lcd_invalidate(0, 0, LCD_WIDTH, LCD_HEIGHT);
+    lcd_flush();
+}
+
+static void run_strip_sprites(void) {
+    // Sprites step right by 3 px; only their old and new footprints are sent
+    for (int frame = 0; frame < 10; frame++) {
+        for (int i = 0; i < 4; i++) {
+            lcd_invalidate(sprite_x + i * 50 - 6, 100 + i * 40 - 6, 16, 13);
+        }
+        sprite_x += 3;
+        lcd_flush();
+    }
+}
+
+static void run_indexed(void) {
+    if (lcd_set_indexed(true) != ESP_OK) return;
+    lcd_invalidate(0, 0, LCD_WIDTH, LCD_HEIGHT);
+    lcd_flush();
+    // Palette swap: no re-render, one full-frame send
+    lcd_palette_set(lcd_palette_index(COLOR_WALL), COLOR_BLUE);
+    lcd_flush();
+    lcd_set_indexed(false);
+}
+
+static void setup_sprites(void) {
+    setup_scene();
+    run_strip_full();
+}
+
+// A Tetris-sized board of tiles with a piece falling down it
+static lcd_tilemap_t board;
+
+static void draw_block(void *arg) {
+    lcd_fill_rect(0, 0, LCD_TILE_SIZE, LCD_TILE_SIZE, (uint16_t)(uintptr_t)arg);
+    lcd_draw_rect(0, 0, LCD_TILE_SIZE, LCD_TILE_SIZE, COLOR_WHITE);
+}
+
+static void setup_tilemap(void) {
+    static const uint16_t colors[] = {COLOR_RED, COLOR_GREEN, COLOR_CYAN};
+    lcd_tilemap_deinit(&board);
+    ESP_ERROR_CHECK(lcd_tilemap_init(&board, 60, 40, 10, 20, 4));
+    for (int id = 1; id < 4; id++) {
+        lcd_tilemap_define(&board, id, draw_block, (void *)(uintptr_t)colors[id - 1]);
+    }
+    for (int row = 12; row < 20; row++) {
+        for (int col = 0; col < 10; col++) {
+            lcd_tilemap_set(&board, col, row, rng() % 4);
+        }
+    }
+    lcd_tilemap_flush(&board);
+}
+
+static void run_tilemap(void) {
+    // A T piece drops ten rows; each step resends only the cells it touched
+    for (int row = 0; row < 10; row++) {
+        if (row > 0) {
+            lcd_tilemap_set(&board, 4, row - 1, 0);
+            lcd_tilemap_set(&board, 3, row, 0);
+            lcd_tilemap_set(&board, 5, row, 0);
+        }
+        lcd_tilemap_set(&board, 4, row, 3);
+        lcd_tilemap_set(&board, 3, row + 1, 3);
+        lcd_tilemap_set(&board, 4, row + 1, 3);
+        lcd_tilemap_set(&board, 5, row + 1, 3);
+        lcd_tilemap_flush(&board);
+    }
+}
+
+// The strip scene with sprites composited into each strip
+static void sprite_scene(void *arg) {
+    scene(arg);
+    for (int i = 0; i < 12; i++) {
+        lcd_draw_sprite(8 + i * 19, 60 + i * 20, &sprite_pacman_right);
+        lcd_draw_sprite(226 - i * 19, 60 + i * 20, &sprite_ghost_red);
+    }
+    lcd_draw_sprite(112, 300, &sprite_frog);
+}
+
+static void setup_sprite_blit(void) {
+    sprite_x = 20;
+    lcd_set_renderer(sprite_scene, NULL);
+}
+
+// A status bar whose score ticks up every frame, sent with and without a
+// shadow of the panel behind it
+static uint32_t hud_score;
+
+static void hud_scene(void *arg) {
+    lcd_fill_rect(0, 0, LCD_WIDTH, 40, COLOR_BLUE);
+    lcd_draw_string(4, 6, "SCORE", COLOR_WHITE, COLOR_BLUE);
+    lcd_draw_number(52, 6, hud_score, COLOR_YELLOW, COLOR_BLUE);
+    lcd_draw_string(4, 24, "LEVEL 3  LINES 12", COLOR_WHITE, COLOR_BLUE);
+}
+
+static void setup_hud(void) {
+    hud_score = 1230;
+    lcd_set_renderer(hud_scene, NULL);
+    run_strip_full();
+}
+
+static void setup_hud_shadow(void) {
+    ESP_ERROR_CHECK(lcd_set_shadow(0, 0, LCD_WIDTH, 40));
+    setup_hud();
+}
+
+static void run_hud(void) {
+    for (int frame = 0; frame < 10; frame++) {
+        hud_score += 10;
+        lcd_invalidate(0, 0, LCD_WIDTH, 40);
+        lcd_flush();
+    }
+}
+
+// A launcher-style list in a hardware scroll band, moved one item at a time
+#define LIST_TOP   60
+#define LIST_ROWS  180
+#define LIST_ITEM  60
+static int list_offset;
+
+static void list_scene(void *arg) {
+    lcd_fill_rect(0, 0, LCD_WIDTH, LIST_TOP, COLOR_BLUE);
+    lcd_draw_string(5, 18, "GAME LAUNCHER", COLOR_WHITE, COLOR_BLUE);
+    for (int i = list_offset / LIST_ITEM; i <= (list_offset + LIST_ROWS) / LIST_ITEM; i++) {
+        int y = LIST_TOP + i * LIST_ITEM - list_offset;
+        if (y >= LIST_TOP + LIST_ROWS) break;
+        char buf[16];
+        snprintf(buf, sizeof(buf), "ITEM %d", i);
+        lcd_fill_rect(5, y, LCD_WIDTH - 10, LIST_ITEM - 5, (i % 2) ? COLOR_WALL : COLOR_BLACK);
+        lcd_draw_rect(5, y, LCD_WIDTH - 10, LIST_ITEM - 5, COLOR_CYAN);
+        lcd_draw_string(65, y + 20, buf, COLOR_WHITE, (i % 2) ? COLOR_WALL : COLOR_BLACK);
+    }
+    lcd_draw_string(10, LCD_HEIGHT - 45, "BtnA=SELECT", COLOR_WHITE, COLOR_BLACK);
+}
+
+static void setup_scroll(void) {
+    list_offset = 0;
+    lcd_set_renderer(list_scene, NULL);
+    ESP_ERROR_CHECK(lcd_scroll_region(LIST_TOP, LIST_ROWS));
+    run_strip_full();
+}
+
+static void run_scroll(void) {
+    // Each step sends one command plus the item that scrolled in
+    for (int step = 0; step < 5; step++) {
+        list_offset += LIST_ITEM;
+        lcd_scroll(LIST_ITEM);
+        lcd_flush();
+    }
+}
+
+static const scenario_t scenarios[] = {
+    {"fill_screen",   NULL,          run_fill_screen},
+    {"fill_rects",    NULL,          run_fill_rects},
+    {"text",          NULL,          run_text},
+    {"shapes",        NULL,          run_shapes},
+    {"strip_full",    setup_scene,   run_strip_full},
+    {"strip_sprites", setup_sprites, run_strip_sprites},
+    {"indexed",       setup_scene,   run_indexed},
+    {"tilemap",       setup_tilemap, run_tilemap},
+    {"sprites",       setup_sprite_blit, run_strip_full},
+    {"hud",           setup_hud,     run_hud},
+    {"hud_shadow",    setup_hud_shadow, run_hud},
+    {"scroll",        setup_scroll,  run_scroll},  // Last: leaves the band set
+};
+
+int main(int argc, char **argv) {
+    const char *out_dir = ".";
+    const char *golden_dir = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:g:")) != -1) {
+        switch (opt) {
+            case 'o': out_dir = optarg; break;
+            case 'g': golden_dir = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-o out_dir] [-g golden_dir]\n", argv[0]);
+                return 2;
+        }
+    }
+    
+    ESP_ERROR_CHECK(lcd_init());
+    
+    int failures = 0;
+    printf("%-14s %8s %9s %8s %8s %5s %8s\n",
+           "scenario", "trans", "bytes", "windows", "pixels", "peak", "bus_us");
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        const scenario_t *s = &scenarios[i];
+        rng_state = 12345;
+        lcd_fill_screen(COLOR_BLACK);
+        if (s->setup) s->setup();
+        lcd_sim_sync();
+        
+        lcd_sim_reset_counters();
+        s->run();
+        lcd_sim_sync();
+        
+        lcd_sim_counters_t c;
+        lcd_sim_get_counters(&c);
+        lcd_set_renderer(NULL, NULL);
+        lcd_set_shadow(0, 0, 0, 0);
+        printf("%-14s %8u %9u %8u %8u %5u %8u\n", s->name,
+               (unsigned)c.transactions, (unsigned)c.bytes, (unsigned)c.windows,
+               (unsigned)c.pixels, (unsigned)c.queued_peak, (unsigned)lcd_sim_bus_us(&c));
+        
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.ppm", out_dir, s->name);
+        if (lcd_sim_dump_ppm(path) != 0) {
+            fprintf(stderr, "%s: cannot write %s\n", s->name, path);
+            failures++;
+        }
+        if (golden_dir != NULL) {
+            uint32_t bad = 0;
+            snprintf(path, sizeof(path), "%s/%s.ppm", golden_dir, s->name);
+            if (lcd_sim_compare_ppm(path, &bad) != 0) {
+                fprintf(stderr, "%s: cannot read golden image %s\n", s->name, path);
+                failures++;
+            } else if (bad != 0) {
+                fprintf(stderr, "%s: %u pixels differ from %s\n", s->name, (unsigned)bad, path);
+                failures++;
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,314 @@
+/**
+ * @file lcd_sim.c
+ * @brief Host-side ILI9341 simulator behind the LCD driver's SPI calls
+ */
+
+#include "lcd_sim.h"
+#include "sdkconfig.h"
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_heap_caps.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Must match PIN_DC in lcd_driver.c
+#define SIM_PIN_DC      13
+#define SIM_QUEUE_MAX   64
+
+#define CMD_CASET       0x2A
+#define CMD_PASET       0x2B
+#define CMD_RAMWR       0x2C
+#define CMD_VSCRDEF     0x33
+#define CMD_MADCTL      0x36
+#define CMD_VSCRSADD    0x37
+
+struct spi_device_t {
+    int clock_hz;
+    int queue_size;
+    transaction_cb_t pre_cb;
+};
+
+static struct spi_device_t device;
+static bool device_added;
+
+// Queued transactions: [head, sent) went out already, [sent, tail) are
+// still "in the DMA" and go out when reaped or on lcd_sim_sync
+static spi_transaction_t *queue[SIM_QUEUE_MAX];
+static uint32_t queue_head;
+static uint32_t queue_sent;
+static uint32_t queue_tail;
+
+// Panel state
+static uint16_t frame[LCD_HEIGHT][LCD_WIDTH];
+static int dc_level;
+static uint8_t cmd;
+static uint8_t params[6];
+static int param_count;
+static int win_x0, win_x1, win_y0, win_y1;
+static int cur_x, cur_y;
+static int pixel_hi = -1;
+static uint8_t madctl;
+static int scroll_tfa, scroll_vsa = LCD_HEIGHT, scroll_vsp;
+
+static lcd_sim_counters_t counters;
+
+static void fail(const char *msg) {
+    fprintf(stderr, "lcd_sim: %s\n", msg);
+    abort();
+}
+
+static void panel_byte(uint8_t b) {
+    if (dc_level == 0) {
+        cmd = b;
+        param_count = 0;
+        pixel_hi = -1;
+        if (cmd == CMD_RAMWR) {
+            cur_x = win_x0;
+            cur_y = win_y0;
+            counters.windows++;
+        }
+        return;
+    }
+    
+    switch (cmd) {
+        case CMD_CASET:
+        case CMD_PASET:
+            if (param_count < 4) params[param_count++] = b;
+            if (param_count == 4) {
+                int lo = (params[0] << 8) | params[1];
+                int hi = (params[2] << 8) | params[3];
+                if (cmd == CMD_CASET) {
+                    win_x0 = lo;
+                    win_x1 = hi;
+                } else {
+                    win_y0 = lo;
+                    win_y1 = hi;
+                }
+            }
+            break;
+        
+        case CMD_MADCTL:
+            madctl = b;
+            break;
+        
+        case CMD_VSCRDEF:
+            if (param_count < 6) params[param_count++] = b;
+            if (param_count == 6) {
+                int tfa = (params[0] << 8) | params[1];
+                int vsa = (params[2] << 8) | params[3];
+                int bfa = (params[4] << 8) | params[5];
+                if (tfa + vsa + bfa != LCD_HEIGHT) fail("VSCRDEF areas do not add up to the panel height");
+                scroll_tfa = tfa;
+                scroll_vsa = vsa;
+            }
+            break;
+        
+        case CMD_VSCRSADD:
+            if (param_count < 2) params[param_count++] = b;
+            if (param_count == 2) {
+                scroll_vsp = (params[0] << 8) | params[1];
+            }
+            break;
+        
+        case CMD_RAMWR: {
+            if (pixel_hi < 0) {
+                pixel_hi = b;
+                break;
+            }
+#if CONFIG_EBADGE_LCD_BYTE_ORDER_LITTLE_ENDIAN
+            uint16_t color = (uint16_t)(pixel_hi | (b << 8));
+#else
+            uint16_t color = (uint16_t)((pixel_hi << 8) | b);
+#endif
+            pixel_hi = -1;
+            if (cur_y <= win_y1 && cur_y < LCD_HEIGHT && cur_x < LCD_WIDTH) {
+                frame[cur_y][cur_x] = color;
+                counters.pixels++;
+            }
+            if (++cur_x > win_x1) {
+                cur_x = win_x0;
+                cur_y++;
+            }
+            break;
+        }
+        
+        default:
+            break;
+    }
+}
+
+static void transmit(spi_transaction_t *t) {
+    if (device.pre_cb) device.pre_cb(t);
+    
+    const uint8_t *data = (t->flags & SPI_TRANS_USE_TXDATA) ? t->tx_data : t->tx_buffer;
+    size_t len = t->length / 8;
+    if ((t->flags & SPI_TRANS_USE_TXDATA) && len > 4) fail("tx_data holds at most 4 bytes");
+    
+    counters.transactions++;
+    counters.bytes += len;
+    for (size_t i = 0; i < len; i++) {
+        panel_byte(data[i]);
+    }
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *cfg, int dma_chan) {
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *cfg,
+                             spi_device_handle_t *handle) {
+    device.clock_hz = cfg->clock_speed_hz;
+    device.queue_size = cfg->queue_size;
+    device.pre_cb = cfg->pre_cb;
+    device_added = true;
+    *handle = &device;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans) {
+    if (queue_tail != queue_head) fail("polling transfer while queued transactions are in flight");
+    transmit(trans);
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans,
+                                 TickType_t ticks_to_wait) {
+    uint32_t in_flight = queue_tail - queue_head;
+    if (in_flight >= (uint32_t)device.queue_size || in_flight >= SIM_QUEUE_MAX) {
+        fail("more transactions queued than queue_size allows");
+    }
+    queue[queue_tail % SIM_QUEUE_MAX] = trans;
+    queue_tail++;
+    if (queue_tail - queue_head > counters.queued_peak) {
+        counters.queued_peak = queue_tail - queue_head;
+    }
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans,
+                                      TickType_t ticks_to_wait) {
+    if (queue_head == queue_tail) fail("waiting for a result with nothing queued");
+    if (queue_sent == queue_head) {
+        transmit(queue[queue_sent % SIM_QUEUE_MAX]);
+        queue_sent++;
+    }
+    *trans = queue[queue_head % SIM_QUEUE_MAX];
+    queue_head++;
+    return ESP_OK;
+}
+
+esp_err_t gpio_config(const gpio_config_t *cfg) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (gpio_num == SIM_PIN_DC) dc_level = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    return 1;  // Buttons are active low, so nothing is pressed
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+    return malloc(size);
+}
+
+void heap_caps_free(void *ptr) {
+    free(ptr);
+}
+
+void vTaskDelay(TickType_t ticks) {
+}
+
+void lcd_sim_get_counters(lcd_sim_counters_t *out) {
+    *out = counters;
+}
+
+void lcd_sim_reset_counters(void) {
+    memset(&counters, 0, sizeof(counters));
+}
+
+uint32_t lcd_sim_bus_us(const lcd_sim_counters_t *c) {
+    if (!device_added || device.clock_hz <= 0) return 0;
+    return (uint32_t)((uint64_t)c->bytes * 8 * 1000000 / device.clock_hz);
+}
+
+void lcd_sim_sync(void) {
+    while (queue_sent != queue_tail) {
+        transmit(queue[queue_sent % SIM_QUEUE_MAX]);
+        queue_sent++;
+    }
+}
+
+const uint16_t *lcd_sim_framebuffer(void) {
+    return &frame[0][0];
+}
+
+uint8_t lcd_sim_madctl(void) {
+    return madctl;
+}
+
+const uint16_t *lcd_sim_display_row(int y) {
+    // Out-of-range start addresses leave the panel unscrolled here
+    int vsp = scroll_vsp;
+    if (vsp < scroll_tfa || vsp >= scroll_tfa + scroll_vsa) vsp = scroll_tfa;
+    if (y >= scroll_tfa && y < scroll_tfa + scroll_vsa) {
+        y = scroll_tfa + (y - scroll_tfa + vsp - scroll_tfa) % scroll_vsa;
+    }
+    return frame[y];
+}
+
+static void rgb888(uint16_t c, uint8_t out[3]) {
+    out[0] = (uint8_t)(((c >> 11) & 0x1F) << 3);
+    out[1] = (uint8_t)(((c >> 5) & 0x3F) << 2);
+    out[2] = (uint8_t)((c & 0x1F) << 3);
+}
+
+int lcd_sim_dump_ppm(const char *path) {
+    lcd_sim_sync();
+    
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) return -1;
+    fprintf(f, "P6\n%d %d\n255\n", LCD_WIDTH, LCD_HEIGHT);
+    for (int y = 0; y < LCD_HEIGHT; y++) {
+        for (int x = 0; x < LCD_WIDTH; x++) {
+            uint8_t px[3];
+            rgb888(lcd_sim_display_row(y)[x], px);
+            fwrite(px, 1, 3, f);
+        }
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+int lcd_sim_compare_ppm(const char *path, uint32_t *mismatches) {
+    lcd_sim_sync();
+    
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return -1;
+    int w, h, maxval;
+    if (fscanf(f, "P6 %d %d %d", &w, &h, &maxval) != 3 || fgetc(f) == EOF ||
+        w != LCD_WIDTH || h != LCD_HEIGHT || maxval != 255) {
+        fclose(f);
+        return -1;
+    }
+    
+    uint32_t bad = 0;
+    for (int y = 0; y < LCD_HEIGHT; y++) {
+        for (int x = 0; x < LCD_WIDTH; x++) {
+            uint8_t want[3];
+            uint8_t have[3];
+            if (fread(want, 1, 3, f) != 3) {
+                fclose(f);
+                return -1;
+            }
+            rgb888(lcd_sim_display_row(y)[x], have);
+            if (memcmp(want, have, 3) != 0) bad++;
+        }
+    }
+    fclose(f);
+    *mismatches = bad;
+    return 0;
+}
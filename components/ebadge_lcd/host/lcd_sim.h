@@ -0,0 +1,50 @@
+/**
+ * @file lcd_sim.h
+ * @brief Host-side ILI9341 simulator behind the LCD driver's SPI calls
+ *
+ * Links in place of the ESP-IDF SPI/GPIO drivers. Every byte the driver
+ * clocks out is decoded (CASET/PASET/RAMWR, MADCTL, VSCRDEF/VSCRSADD) into
+ * an in-memory frame and counted, so render paths can be measured and
+ * compared on a PC.
+ */
+
+#ifndef LCD_SIM_H
+#define LCD_SIM_H
+
+#include <stdint.h>
+#include "lcd_driver.h"
+
+// Bus traffic since the last lcd_sim_reset_counters
+typedef struct {
+    uint32_t transactions;  // SPI transactions, commands included
+    uint32_t bytes;         // Bytes clocked out
+    uint32_t windows;       // RAMWR commands (one per window setup)
+    uint32_t pixels;        // Pixels written into the frame
+    uint32_t queued_peak;   // Most queued transactions in flight at once
+} lcd_sim_counters_t;
+
+void lcd_sim_get_counters(lcd_sim_counters_t *out);
+void lcd_sim_reset_counters(void);
+
+// Time the counted bytes take on the bus at the device's SPI clock
+uint32_t lcd_sim_bus_us(const lcd_sim_counters_t *c);
+
+// Queued transactions are only "sent" once the driver reaps them, which
+// catches buffers reused too early. This pushes out whatever is still
+// queued, as the DMA would on hardware; call it before inspecting the frame.
+void lcd_sim_sync(void);
+
+// LCD_HEIGHT rows of LCD_WIDTH RGB565 pixels in address order (MADCTL
+// mirroring is recorded but not applied)
+const uint16_t *lcd_sim_framebuffer(void);
+uint8_t lcd_sim_madctl(void);
+
+// The memory row the panel shows at screen row y, after vertical scrolling.
+// Snapshots are taken through this.
+const uint16_t *lcd_sim_display_row(int y);
+
+// Write the frame as a binary PPM; compare the frame against one
+int lcd_sim_dump_ppm(const char *path);
+int lcd_sim_compare_ppm(const char *path, uint32_t *mismatches);
+
+#endif // LCD_SIM_H
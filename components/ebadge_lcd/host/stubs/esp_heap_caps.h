@@ -0,0 +1,16 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host stand-in for capability-based allocation (plain malloc)
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT      (1 << 2)
+#define MALLOC_CAP_DMA       (1 << 3)
+#define MALLOC_CAP_INTERNAL  (1 << 11)
+
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void *ptr);
@@ -0,0 +1,14 @@
+/**
+ * @file esp_log.h
+ * @brief Host stand-in for ESP-IDF logging (debug and verbose are dropped)
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) fprintf(stderr, "I (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) do { if (0) fprintf(stderr, fmt, ##__VA_ARGS__); (void)(tag); } while (0)
+#define ESP_LOGV(tag, fmt, ...) do { if (0) fprintf(stderr, fmt, ##__VA_ARGS__); (void)(tag); } while (0)
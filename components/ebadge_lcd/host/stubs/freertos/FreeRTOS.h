@@ -0,0 +1,13 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS types used by the LCD driver
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFF)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
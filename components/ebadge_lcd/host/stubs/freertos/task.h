@@ -0,0 +1,10 @@
+/**
+ * @file task.h
+ * @brief Host stand-in for FreeRTOS task delays (they return immediately)
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+void vTaskDelay(TickType_t ticks);
@@ -0,0 +1,21 @@
+/**
+ * @file sdkconfig.h
+ * @brief Host build configuration
+ *
+ * The LCD options are passed in as compile definitions by CMakeLists.txt;
+ * the fallbacks match the Kconfig defaults.
+ */
+
+#pragma once
+
+#ifndef CONFIG_EBADGE_LCD_FONT_SCALE
+#define CONFIG_EBADGE_LCD_FONT_SCALE 1
+#endif
+
+#if !defined(CONFIG_EBADGE_LCD_ORIENTATION_NORMAL) && !defined(CONFIG_EBADGE_LCD_ORIENTATION_MIRRORED)
+#define CONFIG_EBADGE_LCD_ORIENTATION_MIRRORED 1
+#endif
+
+#if !defined(CONFIG_EBADGE_LCD_BYTE_ORDER_BIG_ENDIAN) && !defined(CONFIG_EBADGE_LCD_BYTE_ORDER_LITTLE_ENDIAN)
+#define CONFIG_EBADGE_LCD_BYTE_ORDER_BIG_ENDIAN 1
+#endif
@@ -0,0 +1,134 @@
+/**
+ * @file lcd_driver.h
+ * @brief ILI9341 LCD display driver
+ */
+
+#ifndef LCD_DRIVER_H
+#define LCD_DRIVER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "driver/spi_master.h"
+#include "esp_err.h"
+
+// LCD dimensions
+#define LCD_WIDTH  240
+#define LCD_HEIGHT 320
+
+// SPI traffic counters (cumulative until lcd_reset_stats)
+typedef struct {
+    uint32_t transactions;              // SPI transactions, commands included
+    uint32_t bytes;                     // Bytes clocked out
+    uint32_t windows;                   // lcd_set_window calls
+    uint32_t fill_calls;                // lcd_fill_rect calls
+    uint32_t fill_transactions;         // Data transactions issued by fills
+    uint32_t fill_legacy_transactions;  // Transactions the old per-pixel fill would have used
+    uint32_t strips;                    // Off-screen strips sent by lcd_flush
+    uint32_t glyph_hits;                // Characters served from the glyph cache
+    uint32_t glyph_misses;              // Characters expanded from the font
+    uint32_t scrolls;                   // lcd_scroll calls
+    uint32_t dl_overflows;              // Frames too big for the display list
+} lcd_stats_t;
+
+// What the most recent lcd_flush cost
+typedef struct {
+    uint32_t rects;         // Dirty rects after merging
+    uint32_t pixels;        // Pixels rasterized
+    uint32_t unchanged;     // Of those, pixels the shadow kept off the bus
+    uint32_t transactions;  // SPI transactions, window setup included
+    uint32_t bytes;         // Bytes clocked out
+    uint32_t commands;      // Draw calls the render callback recorded
+    uint32_t draws;         // Recorded draws replayed, once per band they touch
+    uint32_t culled;        // Replays skipped as hidden under later opaque draws
+    bool collapsed;         // Fragmentation forced a single bounding box
+} lcd_frame_stats_t;
+
+// Scene callback for the strip renderer. It should draw the whole scene with
+// the normal lcd_* calls. lcd_flush runs it once to record a display list,
+// then replays only the draws that reach each dirty strip and are not
+// covered by later opaque ones (rects, bitmaps, text with a background).
+// Text is copied, but bitmap and sprite pixels must stay valid until
+// lcd_flush returns. A scene too big for the list is drawn by calling back
+// once per strip instead.
+typedef void (*lcd_render_fn_t)(void *arg);
+
+// Initialize LCD
+esp_err_t lcd_init(void);
+
+// Basic drawing functions
+void lcd_fill_screen(uint16_t color);
+void lcd_draw_pixel(int x, int y, uint16_t color);
+void lcd_draw_rect(int x, int y, int w, int h, uint16_t color);
+void lcd_fill_rect(int x, int y, int w, int h, uint16_t color);
+void lcd_draw_circle(int x, int y, int radius, uint16_t color);
+void lcd_fill_circle(int x, int y, int radius, uint16_t color);
+void lcd_draw_char(int x, int y, char c, uint16_t color, uint16_t bg);
+void lcd_draw_string(int x, int y, const char* str, uint16_t color, uint16_t bg);
+void lcd_draw_number(int x, int y, uint32_t num, uint16_t color, uint16_t bg);
+
+// Buffer operations. These address panel memory directly, so while a
+// scroll band is moved its rows are not where they show on screen.
+void lcd_set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+void lcd_write_data_buffer(const uint16_t* data, uint32_t len);
+
+// Bitmaps hold RGB565 pixels in the order they go out on the wire, as
+// produced by lcd_render_to (which runs fn with drawing redirected into
+// buf, coordinates relative to its top-left corner). lcd_draw_bitmap is
+// clipped like any other drawing call and works inside a render pass.
+void lcd_render_to(uint16_t *buf, int w, int h, lcd_render_fn_t fn, void *arg);
+void lcd_draw_bitmap(int x, int y, int w, int h, const uint16_t *pixels);
+
+// RLE sprite with transparency, generated from PNGs by tools/png2sprite.py.
+// Each row is a list of runs ending in a zero word. A run header holds the
+// transparent pixels to skip (high byte), LCD_SPRITE_FILL and a pixel count;
+// a fill run is followed by one RGB565 color, any other run by count colors.
+// Inside a render pass runs are written straight into the strip, so a
+// sprite costs no transfers of its own.
+#define LCD_SPRITE_FILL   0x80
+#define LCD_SPRITE_COUNT  0x7F
+
+typedef struct {
+    uint16_t width, height;
+    const uint16_t *data;
+} lcd_sprite_t;
+
+void lcd_draw_sprite(int x, int y, const lcd_sprite_t *sprite);
+
+// Hardware vertical scrolling. Screen rows [top, top + height) become a band
+// that lcd_scroll moves up by dy rows (down when negative) with a single
+// command; the rows that scroll in are passed to lcd_invalidate, so the
+// renderer only draws those. Other drawing keeps using screen coordinates.
+// Height 0 turns the band off. Changing the band while it is moved
+// invalidates it.
+esp_err_t lcd_scroll_region(int top, int height);
+void lcd_scroll(int dy);
+
+// Strip renderer with dirty-rectangle tracking. Overlapping and adjacent
+// rects are merged; a fragmented list falls back to its bounding box.
+void lcd_set_renderer(lcd_render_fn_t fn, void *arg);
+void lcd_invalidate(int x, int y, int w, int h);
+void lcd_flush(void);
+void lcd_get_frame_stats(lcd_frame_stats_t *out);
+
+// Shadow copy of the panel over one area (w * h * 2 bytes). Strips inside it
+// are compared with what was last sent and only the changed spans go out,
+// each with its own window; gaps of a few unchanged pixels are sent rather
+// than split on. Suits HUDs and grids where little changes per frame. The
+// area is resent whole after a scroll that reaches it or a raw
+// lcd_write_data_buffer. Width 0 turns it off.
+esp_err_t lcd_set_shadow(int x, int y, int w, int h);
+
+// Optional 8-bit indexed framebuffer (LCD_WIDTH x LCD_HEIGHT bytes of
+// internal RAM). While enabled, drawing calls write palette indices, colors
+// get an entry on first use and lcd_flush expands dirty areas through the
+// palette. Drawing outside the renderer invalidates what it touches.
+// lcd_palette_set changes what an entry shows without redrawing anything.
+esp_err_t lcd_set_indexed(bool enable);
+uint8_t lcd_palette_index(uint16_t color);
+void lcd_palette_set(uint8_t index, uint16_t color);
+
+// Statistics
+void lcd_get_stats(lcd_stats_t *out);
+void lcd_reset_stats(void);
+
+#endif // LCD_DRIVER_H
@@ -0,0 +1,46 @@
+/**
+ * @file lcd_tilemap.h
+ * @brief Tile-map layer for grid games
+ */
+
+#ifndef LCD_TILEMAP_H
+#define LCD_TILEMAP_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "lcd_driver.h"
+
+#define LCD_TILE_SIZE    12
+#define LCD_TILE_PIXELS  (LCD_TILE_SIZE * LCD_TILE_SIZE)
+
+// A cols x rows grid of tile ids with its top-left corner at (x, y). Every
+// id has a cached LCD_TILE_SIZE square image. Cells whose id changes are
+// marked dirty, and only those are redrawn, merged into horizontal runs.
+typedef struct {
+    int x, y;
+    int cols, rows;
+    int image_count;
+    uint8_t *cells;     // Row-major tile ids
+    uint32_t *dirty;    // One bit per cell
+    uint16_t *images;   // image_count tiles in wire order
+} lcd_tilemap_t;
+
+// All cells start as id 0 and dirty. The grid must lie on screen.
+esp_err_t lcd_tilemap_init(lcd_tilemap_t *map, int x, int y, int cols, int rows, int image_count);
+void lcd_tilemap_deinit(lcd_tilemap_t *map);
+
+// Pre-render tile `id` by running draw with coordinates relative to the tile
+void lcd_tilemap_define(lcd_tilemap_t *map, uint8_t id, lcd_render_fn_t draw, void *arg);
+
+void lcd_tilemap_set(lcd_tilemap_t *map, int col, int row, uint8_t id);
+void lcd_tilemap_mark_all(lcd_tilemap_t *map);
+
+// Send the dirty tiles straight to the panel (anything drawn over them is
+// overwritten), or hand them to lcd_invalidate for the strip renderer,
+// whose callback then uses lcd_tilemap_draw to put the tiles underneath.
+// In indexed mode use the latter, so the indexed frame stays current.
+void lcd_tilemap_flush(lcd_tilemap_t *map);
+void lcd_tilemap_invalidate(lcd_tilemap_t *map);
+void lcd_tilemap_draw(const lcd_tilemap_t *map);
+
+#endif // LCD_TILEMAP_H
@@ -0,0 +1,1861 @@
+/**
+ * @file lcd_driver.c
+ * @brief ILI9341 LCD display driver for ESP32-S3 e-Badge
+ *
+ * Shared by the launcher and all games. Orientation, pixel byte order and
+ * font scale come from the "eBadge LCD" menu in menuconfig.
+ */
+
+#include "lcd_driver.h"
+#include "lcd_internal.h"
+#include "ebadge_trace.h"
+#include "sdkconfig.h"
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <string.h>
+
+// LCD Pins
+#define PIN_MOSI   11
+#define PIN_CLK    12
+#define PIN_CS     9
+#define PIN_DC     13
+#define PIN_RST    48
+
+// ILI9341 Commands
+#define CMD_SWRESET   0x01
+#define CMD_SLPOUT    0x11
+#define CMD_DISPON    0x29
+#define CMD_CASET     0x2A
+#define CMD_PASET     0x2B
+#define CMD_RAMWR     0x2C
+#define CMD_VSCRDEF   0x33
+#define CMD_MADCTL    0x36
+#define CMD_VSCRSADD  0x37
+#define CMD_COLMOD    0x3A
+
+// SPI transfer sizing: one DMA transaction carries up to LCD_DMA_LINES full rows
+#define LCD_MAX_TRANSFER   (LCD_DMA_PIXELS * 2)
+#define LCD_QUEUE_SIZE     12  // Room for two strips (window setup + data) in flight
+#define LCD_SHADOW_GAP     24  // Unchanged pixels worth resending to save a window setup
+#define LCD_SHADOW_SPANS   8   // Changed spans tracked per row before they are merged
+
+// Text: font8x8 glyphs scaled up LCD_FONT_SCALE times
+#define LCD_FONT_SCALE     CONFIG_EBADGE_LCD_FONT_SCALE
+#define LCD_GLYPH_SIZE     (8 * LCD_FONT_SCALE)
+#define LCD_GLYPH_PIXELS   (LCD_GLYPH_SIZE * LCD_GLYPH_SIZE)
+#define LCD_GLYPH_CACHE    16
+
+#define LCD_PALETTE_SIZE   256
+
+// Pixel as it sits in a DMA buffer. Resolved at compile time so buffers are
+// filled in wire order without a per-pixel branch.
+#if CONFIG_EBADGE_LCD_BYTE_ORDER_LITTLE_ENDIAN
+#define LCD_WIRE(c)        ((uint16_t)(c))  // Low byte first
+#else
+#define LCD_WIRE(c)        ((uint16_t)(((c) >> 8) | ((c) << 8)))  // ILI9341 native, high byte first
+#endif
+
+#if CONFIG_EBADGE_LCD_ORIENTATION_MIRRORED
+#define LCD_MADCTL         0x48  // MX=1 (columns mirrored), BGR=1
+#else
+#define LCD_MADCTL         0x08  // No mirroring, BGR=1
+#endif
+
+static const char *TAG = "lcd";
+static spi_device_handle_t spi;
+
+// Queued transactions are counted so callers can wait for a specific one.
+// Results come back in queue order, so reaping up to a sequence number means
+// everything queued before it has left the DMA buffers.
+static uint32_t queued_seq;
+static uint32_t reaped_seq;
+
+// Reusable DMA-capable buffer holding an expanded fill color
+static uint16_t *fill_buf;
+static uint16_t fill_buf_color;
+static uint32_t fill_buf_len;  // pixels currently expanded with fill_buf_color
+
+// Descriptors for queued transactions, one per slot of the SPI queue
+static spi_transaction_t queue_trans[LCD_QUEUE_SIZE];
+
+// Strip renderer: dirty rectangles are rasterized off-screen by the render
+// callback in strips of at most LCD_DMA_PIXELS and sent with one window and
+// one DMA burst each.
+#define LCD_MAX_DIRTY_RECTS 16
+
+typedef struct {
+    int16_t x0, y0, x1, y1;  // x1/y1 exclusive
+} dirty_rect_t;
+
+// Ping-pong strip buffers: one is rasterized while the other is on the wire
+static uint16_t *strip_buf[2];
+static uint32_t strip_seq[2];
+static int strip_slot;
+static dirty_rect_t dirty[LCD_MAX_DIRTY_RECTS];
+static int dirty_count;
+static bool dirty_collapsed;
+static lcd_frame_stats_t frame_stats;
+static lcd_render_fn_t render_fn;
+static void *render_arg;
+
+// Display list: lcd_flush runs the render callback once to record its draw
+// calls, bins them by bands of LCD_DL_BIN_ROWS screen rows and replays each
+// band back to front, skipping draws that later opaque ones cover. A frame
+// that does not fit is rendered by calling back per strip instead.
+#define LCD_DL_COMMANDS   512
+#define LCD_DL_ENTRIES    1024  // Command references across all bins
+#define LCD_DL_TEXT       512   // Characters of text per frame
+#define LCD_DL_BIN_ROWS   LCD_DMA_LINES
+#define LCD_DL_BINS       ((LCD_HEIGHT + LCD_DL_BIN_ROWS - 1) / LCD_DL_BIN_ROWS)
+#define LCD_DL_OCCLUDERS  4     // Opaque areas tracked while culling a band
+
+typedef enum {
+    DL_RECT,
+    DL_CIRCLE,
+    DL_FILL_CIRCLE,
+    DL_TEXT,
+    DL_BITMAP,
+    DL_SPRITE,
+} dl_kind_t;
+
+typedef struct {
+    dirty_rect_t box;   // Screen area the draw can touch
+    uint8_t kind;
+    bool opaque;        // Covers every pixel of box
+    uint16_t len;       // Text characters
+    uint16_t color, bg;
+    int16_t x, y, w, h; // w is the radius for circles
+    const void *data;   // Bitmap pixels, sprite, or text in dl_text
+} dl_cmd_t;
+
+static dl_cmd_t dl_cmds[LCD_DL_COMMANDS];
+static char dl_text[LCD_DL_TEXT];
+static uint16_t dl_bin_start[LCD_DL_BINS + 1];
+static uint16_t dl_entries[LCD_DL_ENTRIES];
+static uint16_t dl_visible[LCD_DL_ENTRIES];
+static int dl_count;
+static int dl_text_used;
+static bool dl_recording;   // Inside the recording call of the render callback
+static bool dl_overflow;    // This frame did not fit
+
+// Off-screen draw target. While buf is set, drawing calls write into it
+// (row stride == w) instead of going out over SPI.
+typedef struct {
+    uint16_t *buf;
+    int x, y, w, h;
+} draw_target_t;
+
+static draw_target_t target;
+
+// Hardware vertical scroll: screen rows [scroll_top, scroll_top + scroll_height)
+// show panel memory rotated by scroll_offset rows. Drawing calls keep using
+// screen rows and are mapped to memory rows on the way out.
+static int scroll_top;
+static int scroll_height;
+static int scroll_offset;
+
+// Optional shadow of what the panel shows over one screen area, in wire
+// order with row stride shadow_area.x1 - x0. Strips inside it only send the
+// spans that differ. Stale rows are not known to match and go out whole.
+#define LCD_SHADOW_RECTS 32  // Changed rects per strip before it is sent whole
+
+static uint16_t *shadow_buf;
+static dirty_rect_t shadow_area;
+static dirty_rect_t shadow_stale;
+static uint16_t *pack_buf[2];  // Changed spans gathered for the strip in the same slot
+
+// Two pixels compared at once; may_alias since it reads uint16_t rows
+typedef uint32_t __attribute__((may_alias)) pixel_pair_t;
+
+static lcd_stats_t stats;
+
+// Expanded glyphs keyed by (char, fg, bg), replaced round-robin
+typedef struct {
+    uint16_t fg;
+    uint16_t bg;
+    char c;
+    bool valid;
+} glyph_tag_t;
+
+// Indexed-color mode: an 8-bit frame in internal RAM plus a palette LUT.
+// Entries are keyed by the RGB565 color games draw with, so drawing code
+// stays the same; lcd_palette_set only changes what an entry shows.
+static uint8_t *index_fb;
+static uint16_t palette_key[LCD_PALETTE_SIZE];
+static uint16_t palette_wire[LCD_PALETTE_SIZE];
+static int palette_used;
+static int palette_last;        // Entry returned by the previous lookup
+static bool palette_dirty;      // An entry changed; the whole frame must go out
+static dirty_rect_t index_clip; // Index drawing is clipped to this area
+static bool index_rendering;    // Inside lcd_flush's render pass
+static dirty_rect_t index_touched; // Drawn outside the render pass, still to send
+
+static uint16_t *glyph_pixels;  // LCD_GLYPH_CACHE glyphs back to back, DMA capable
+static glyph_tag_t glyph_tags[LCD_GLYPH_CACHE];
+static int glyph_next;
+
+// Simple 8x8 font for faster rendering
+static const uint8_t font8x8[96][8] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00,0x00, 0x00, 0x00}, // Space
+    {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, // !
+    {0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // "
+    {0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00}, // #
+    {0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00}, // $
+    {0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00}, // %
+    {0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00}, // &
+    {0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00}, // '
+    {0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00}, // (
+    {0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00}, // )
+    {0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00}, // *
+    {0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00}, // +
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ,
+    {0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00}, // -
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // .
+    {0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00}, // /
+    {0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00}, // 0
+    {0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00}, // 1
+    {0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00}, // 2
+    {0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00}, // 3
+    {0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00}, // 4
+    {0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00}, // 5
+    {0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00}, // 6
+    {0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00}, // 7
+    {0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00}, // 8
+    {0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00}, // 9
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // :
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ;
+    {0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00}, // <
+    {0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00}, // =
+    {0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00}, // >
+    {0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00}, // ?
+    {0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00}, // @
+    {0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00}, // A
+    {0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00}, // B
+    {0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00}, // C
+    {0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00}, // D
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00}, // E
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00}, // F
+    {0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00}, // G
+    {0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00}, // H
+    {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // I
+    {0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00}, // J
+    {0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00}, // K
+    {0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00}, // L
+    {0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00}, // M
+    {0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00}, // N
+    {0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00}, // O
+    {0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00}, // P
+    {0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00}, // Q
+    {0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00}, // R
+    {0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00}, // S
+    {0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // T
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00}, // U
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // V
+    {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00}, // W
+    {0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00}, // X
+    {0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00}, // Y
+    {0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00}, // Z
+    {0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00}, // [
+    {0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00}, // backslash
+    {0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00}, // ]
+    {0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00}, // ^
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, // _
+    {0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00}, // `
+    {0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00}, // a
+    {0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00}, // b
+    {0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00}, // c
+    {0x38, 0x30, 0x30, 0x3e, 0x33, 0x33, 0x6E, 0x00}, // d
+    {0x00, 0x00, 0x1E, 0x33, 0x3f, 0x03, 0x1E, 0x00}, // e
+    {0x1C, 0x36, 0x06, 0x0f, 0x06, 0x06, 0x0F, 0x00}, // f
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // g
+    {0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00}, // h
+    {0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // i
+    {0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E}, // j
+    {0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00}, // k
+    {0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // l
+    {0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00}, // m
+    {0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00}, // n
+    {0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00}, // o
+    {0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F}, // p
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78}, // q
+    {0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00}, // r
+    {0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00}, // s
+    {0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00}, // t
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00}, // u
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // v
+    {0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00}, // w
+    {0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00}, // x
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // y
+    {0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00}, // z
+    {0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00}, // {
+    {0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00}, // |
+    {0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00}, // }
+    {0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ~
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}  // DEL
+};
+
+// Runs right before every transaction (queued or polled): t->user holds the
+// DC level, 0 for a command byte and 1 for parameters/pixel data
+static void IRAM_ATTR lcd_spi_pre_cb(spi_transaction_t *t) {
+    gpio_set_level(PIN_DC, (int)(intptr_t)t->user);
+}
+
+// Collect finished queued transactions until `seq` has completed
+static void lcd_reap_until(uint32_t seq) {
+    if ((int32_t)(seq - reaped_seq) <= 0) {
+        return;
+    }
+    EBADGE_TRACE_BEGIN(EBADGE_TRACE_LCD_SPI_WAIT, seq - reaped_seq);
+    spi_transaction_t *done;
+    while ((int32_t)(seq - reaped_seq) > 0) {
+        spi_device_get_trans_result(spi, &done, portMAX_DELAY);
+        reaped_seq++;
+    }
+    EBADGE_TRACE_END(EBADGE_TRACE_LCD_SPI_WAIT, 0);
+}
+
+// Polling transfers may not overlap queued ones, so they drain the queue first
+static void lcd_wait_idle(void) {
+    lcd_reap_until(queued_seq);
+}
+
+static void lcd_queue(spi_transaction_t *t) {
+    if (queued_seq - reaped_seq >= LCD_QUEUE_SIZE) {
+        lcd_reap_until(reaped_seq + 1);
+    }
+    spi_device_queue_trans(spi, t, portMAX_DELAY);
+    queued_seq++;
+    stats.transactions++;
+    stats.bytes += t->length / 8;
+}
+
+static void lcd_cmd(uint8_t cmd) {
+    lcd_wait_idle();
+    spi_transaction_t t = {.length=8, .tx_buffer=&cmd, .user=(void*)0};
+    spi_device_polling_transmit(spi, &t);
+    stats.transactions++;
+    stats.bytes += 1;
+}
+
+static void lcd_data(const uint8_t *data, int len) {
+    if (len == 0) return;
+    lcd_wait_idle();
+    spi_transaction_t t = {.length=len*8, .tx_buffer=data, .user=(void*)1};
+    spi_device_polling_transmit(spi, &t);
+    stats.transactions++;
+    stats.bytes += len;
+}
+
+// A cleared descriptor for the next queued transaction. Its slot was last
+// used LCD_QUEUE_SIZE transactions ago, so that one is reaped first.
+static spi_transaction_t *lcd_next_trans(void) {
+    if (queued_seq - reaped_seq >= LCD_QUEUE_SIZE) {
+        lcd_reap_until(reaped_seq + 1);
+    }
+    spi_transaction_t *t = &queue_trans[queued_seq % LCD_QUEUE_SIZE];
+    memset(t, 0, sizeof(*t));
+    return t;
+}
+
+// Queue a window setup as five small transactions using inline tx_data
+static void lcd_queue_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
+    const uint8_t cmds[3] = {CMD_CASET, CMD_PASET, CMD_RAMWR};
+    const uint16_t lo[2] = {x0, y0};
+    const uint16_t hi[2] = {x1, y1};
+    
+    for (int i = 0; i < 3; i++) {
+        spi_transaction_t *c = lcd_next_trans();
+        c->flags = SPI_TRANS_USE_TXDATA;
+        c->length = 8;
+        c->tx_data[0] = cmds[i];
+        c->user = (void*)0;
+        lcd_queue(c);
+        if (i == 2) break;
+        
+        spi_transaction_t *d = lcd_next_trans();
+        d->flags = SPI_TRANS_USE_TXDATA;
+        d->length = 32;
+        d->tx_data[0] = lo[i] >> 8;
+        d->tx_data[1] = lo[i] & 0xFF;
+        d->tx_data[2] = hi[i] >> 8;
+        d->tx_data[3] = hi[i] & 0xFF;
+        d->user = (void*)1;
+        lcd_queue(d);
+    }
+    stats.windows++;
+}
+
+// Stream `count` pixels of one color into the current window.
+// The color is expanded once into the DMA buffer and the same buffer is
+// queued repeatedly. The last chunks may still be in flight on return; the
+// next polled command waits for them.
+static uint32_t lcd_fill_pixels(uint16_t color, uint32_t count) {
+    uint16_t wire = LCD_WIRE(color);
+    uint32_t need = (count < LCD_DMA_PIXELS) ? count : LCD_DMA_PIXELS;
+    
+    if (fill_buf_color != wire || fill_buf_len < need) {
+        lcd_wait_idle();
+        uint32_t pair = ((uint32_t)wire << 16) | wire;
+        uint32_t *p = (uint32_t *)fill_buf;
+        for (uint32_t i = 0; i < (need + 1) / 2; i++) {
+            p[i] = pair;
+        }
+        fill_buf_color = wire;
+        fill_buf_len = (need + 1) & ~1u;
+    }
+    
+    uint32_t issued = 0;
+    while (count > 0) {
+        uint32_t chunk = (count < LCD_DMA_PIXELS) ? count : LCD_DMA_PIXELS;
+        spi_transaction_t *t = lcd_next_trans();
+        t->length = chunk * 16;
+        t->tx_buffer = fill_buf;
+        t->user = (void*)1;
+        lcd_queue(t);
+        issued++;
+        count -= chunk;
+    }
+    return issued;
+}
+
+// Screen rows [y, y + n) as a run that is contiguous in panel memory.
+// Returns the run's length (at most n) and sets *gram to its first row;
+// callers loop until all n rows are covered.
+static int gram_rows(int y, int n, int *gram) {
+    int end = scroll_top + scroll_height;
+    *gram = y;
+    if (scroll_offset == 0 || y >= end) return n;
+    if (y < scroll_top) return (y + n < scroll_top) ? n : scroll_top - y;
+    
+    // Inside the band, memory wraps back to its top at screen row `wrap`
+    int wrap = end - scroll_offset;
+    if (y < wrap) {
+        *gram = y + scroll_offset;
+        return (y + n < wrap) ? n : wrap - y;
+    }
+    *gram = y + scroll_offset - scroll_height;
+    return (y + n < end) ? n : end - y;
+}
+
+static inline int rect_area(const dirty_rect_t *r) {
+    return (r->x1 - r->x0) * (r->y1 - r->y0);
+}
+
+static inline dirty_rect_t rect_union(const dirty_rect_t *a, const dirty_rect_t *b) {
+    dirty_rect_t u = {
+        .x0 = (a->x0 < b->x0) ? a->x0 : b->x0,
+        .y0 = (a->y0 < b->y0) ? a->y0 : b->y0,
+        .x1 = (a->x1 > b->x1) ? a->x1 : b->x1,
+        .y1 = (a->y1 > b->y1) ? a->y1 : b->y1,
+    };
+    return u;
+}
+
+static inline bool rect_overlap(const dirty_rect_t *a, const dirty_rect_t *b) {
+    return a->x0 < b->x1 && b->x0 < a->x1 && a->y0 < b->y1 && b->y0 < a->y1;
+}
+
+// Copy the part of a w x h block (row stride `stride`) that falls inside the
+// shadow area; a NULL block fills it with color instead
+static void shadow_write(int x, int y, int w, int h, const uint16_t *pixels,
+                         int stride, uint16_t color) {
+    if (shadow_buf == NULL) return;
+    int x0 = (x > shadow_area.x0) ? x : shadow_area.x0;
+    int y0 = (y > shadow_area.y0) ? y : shadow_area.y0;
+    int x1 = (x + w < shadow_area.x1) ? x + w : shadow_area.x1;
+    int y1 = (y + h < shadow_area.y1) ? y + h : shadow_area.y1;
+    if (x0 >= x1 || y0 >= y1) return;
+    
+    int sw = shadow_area.x1 - shadow_area.x0;
+    for (int row = y0; row < y1; row++) {
+        uint16_t *dst = shadow_buf + (row - shadow_area.y0) * sw + (x0 - shadow_area.x0);
+        if (pixels != NULL) {
+            memcpy(dst, pixels + (row - y) * stride + (x0 - x), (x1 - x0) * sizeof(uint16_t));
+        } else {
+            for (int col = x0; col < x1; col++) {
+                *dst++ = color;
+            }
+        }
+    }
+}
+
+// The panel changed in a way the shadow cannot follow: mark the overlap
+// stale and have the renderer send it again
+static void shadow_forget(int x0, int y0, int x1, int y1) {
+    if (shadow_buf == NULL) return;
+    dirty_rect_t r = {x0, y0, x1, y1};
+    if (!rect_overlap(&r, &shadow_area)) return;
+    if (r.x0 < shadow_area.x0) r.x0 = shadow_area.x0;
+    if (r.y0 < shadow_area.y0) r.y0 = shadow_area.y0;
+    if (r.x1 > shadow_area.x1) r.x1 = shadow_area.x1;
+    if (r.y1 > shadow_area.y1) r.y1 = shadow_area.y1;
+    
+    if (shadow_stale.x0 < shadow_stale.x1) {
+        r = rect_union(&r, &shadow_stale);
+    }
+    shadow_stale = r;
+    lcd_invalidate(r.x0, r.y0, r.x1 - r.x0, r.y1 - r.y0);
+}
+
+// Send a w x h block of wire-order pixels (row stride w) to screen
+// coordinates, polling
+static void lcd_write_rect(int x, int y, int w, int h, const uint16_t *pixels) {
+    shadow_write(x, y, w, h, pixels, w, 0);
+    for (int row = 0; row < h; ) {
+        int gram;
+        int n = gram_rows(y + row, h - row, &gram);
+        lcd_set_window(x, gram, x + w - 1, gram + n - 1);
+        lcd_data((const uint8_t *)(pixels + row * w), n * w * 2);
+        row += n;
+    }
+}
+
+// Queue the same without waiting. pixels stays owned by the SPI driver
+// until the last transaction queued here is reaped.
+static void lcd_queue_rect(int x, int y, int w, int h, const uint16_t *pixels) {
+    for (int row = 0; row < h; ) {
+        int gram;
+        int n = gram_rows(y + row, h - row, &gram);
+        lcd_queue_window(x, gram, x + w - 1, gram + n - 1);
+        spi_transaction_t *t = lcd_next_trans();
+        t->length = w * n * 16;
+        t->tx_buffer = pixels + row * w;
+        t->user = (void*)1;
+        lcd_queue(t);
+        row += n;
+    }
+}
+
+esp_err_t lcd_init(void) {
+    ESP_LOGI(TAG, "Initializing LCD");
+    
+    // Configure GPIO for DC and RST
+    gpio_config_t io = {
+        .pin_bit_mask = (1ULL<<PIN_DC) | (1ULL<<PIN_RST),
+        .mode = GPIO_MODE_OUTPUT,
+    };
+    gpio_config(&io);
+    
+    // Initialize SPI bus
+    spi_bus_config_t bus = {
+        .mosi_io_num = PIN_MOSI,
+        .sclk_io_num = PIN_CLK,
+        .miso_io_num = -1,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = LCD_MAX_TRANSFER,
+    };
+    ESP_ERROR_CHECK(spi_bus_initialize(SPI2_HOST, &bus, SPI_DMA_CH_AUTO));
+    
+    // Add SPI device
+    spi_device_interface_config_t dev = {
+        .clock_speed_hz = 40*1000*1000,  // 40MHz
+        .mode = 0,
+        .spics_io_num = PIN_CS,
+        .queue_size = LCD_QUEUE_SIZE,
+        .pre_cb = lcd_spi_pre_cb,
+    };
+    ESP_ERROR_CHECK(spi_bus_add_device(SPI2_HOST, &dev, &spi));
+    
+    // Fill buffer must be DMA-capable so queued transfers can read it directly
+    fill_buf = heap_caps_malloc(LCD_MAX_TRANSFER, MALLOC_CAP_DMA);
+    if (fill_buf == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %d byte DMA fill buffer", LCD_MAX_TRANSFER);
+        return ESP_ERR_NO_MEM;
+    }
+    fill_buf_len = 0;
+    
+    for (int i = 0; i < 2; i++) {
+        strip_buf[i] = heap_caps_malloc(LCD_MAX_TRANSFER, MALLOC_CAP_DMA);
+        if (strip_buf[i] == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate %d byte strip buffer", LCD_MAX_TRANSFER);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    glyph_pixels = heap_caps_malloc(LCD_GLYPH_CACHE * LCD_GLYPH_PIXELS * sizeof(uint16_t),
+                                    MALLOC_CAP_DMA);
+    if (glyph_pixels == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate glyph cache");
+        return ESP_ERR_NO_MEM;
+    }
+    dirty_count = 0;
+    
+    // Hardware reset
+    gpio_set_level(PIN_RST, 0);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    gpio_set_level(PIN_RST, 1);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    
+    // Initialize display
+    lcd_cmd(CMD_SWRESET);
+    vTaskDelay(pdMS_TO_TICKS(150));
+    lcd_cmd(CMD_SLPOUT);
+    vTaskDelay(pdMS_TO_TICKS(500));
+    
+    // Set 16-bit color mode
+    lcd_cmd(CMD_COLMOD);
+    uint8_t d1 = 0x55;  // 16-bit RGB565
+    lcd_data(&d1, 1);
+    
+    // Set memory access order
+    lcd_cmd(CMD_MADCTL);
+    uint8_t d2 = LCD_MADCTL;
+    lcd_data(&d2, 1);
+    
+    lcd_cmd(CMD_DISPON);
+    vTaskDelay(pdMS_TO_TICKS(200));  // Increased delay for display stabilization
+    
+    ESP_LOGI(TAG, "LCD initialized successfully");
+    return ESP_OK;
+}
+
+void lcd_set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
+    uint8_t data[4];
+    lcd_cmd(CMD_CASET);
+    data[0] = x0>>8; data[1] = x0&0xFF; data[2] = x1>>8; data[3] = x1&0xFF;
+    lcd_data(data, 4);
+    lcd_cmd(CMD_PASET);
+    data[0] = y0>>8; data[1] = y0&0xFF; data[2] = y1>>8; data[3] = y1&0xFF;
+    lcd_data(data, 4);
+    lcd_cmd(CMD_RAMWR);
+    stats.windows++;
+}
+
+void lcd_fill_screen(uint16_t color) {
+    uint32_t before = stats.fill_transactions;
+    lcd_fill_rect(0, 0, LCD_WIDTH, LCD_HEIGHT, color);
+    ESP_LOGD(TAG, "fill_screen: %lu data transactions (per-pixel path: %d)",
+             (unsigned long)(stats.fill_transactions - before), LCD_WIDTH * LCD_HEIGHT);
+}
+
+// Rasterize a clipped rectangle into the off-screen target
+static void target_fill(int x, int y, int w, int h, uint16_t color) {
+    int x1 = x + w;
+    int y1 = y + h;
+    if (x < target.x) x = target.x;
+    if (y < target.y) y = target.y;
+    if (x1 > target.x + target.w) x1 = target.x + target.w;
+    if (y1 > target.y + target.h) y1 = target.y + target.h;
+    if (x >= x1 || y >= y1) return;
+    
+    uint16_t wire = LCD_WIRE(color);
+    for (int row = y; row < y1; row++) {
+        uint16_t *p = target.buf + (row - target.y) * target.w + (x - target.x);
+        for (int i = x; i < x1; i++) {
+            *p++ = wire;
+        }
+    }
+}
+
+uint8_t lcd_palette_index(uint16_t color) {
+    if (palette_used > 0 && palette_key[palette_last] == color) {
+        return palette_last;
+    }
+    for (int i = 0; i < palette_used; i++) {
+        if (palette_key[i] == color) {
+            palette_last = i;
+            return i;
+        }
+    }
+    if (palette_used < LCD_PALETTE_SIZE) {
+        palette_key[palette_used] = color;
+        palette_wire[palette_used] = LCD_WIRE(color);
+        palette_last = palette_used;
+        return palette_used++;
+    }
+    
+    // Palette full: fall back to the closest existing key
+    int best = 0;
+    int best_dist = INT32_MAX;
+    for (int i = 0; i < LCD_PALETTE_SIZE; i++) {
+        int dr = ((palette_key[i] >> 11) & 0x1F) - ((color >> 11) & 0x1F);
+        int dg = ((palette_key[i] >> 5) & 0x3F) - ((color >> 5) & 0x3F);
+        int db = (palette_key[i] & 0x1F) - (color & 0x1F);
+        int dist = 4*dr*dr + dg*dg + 4*db*db;
+        if (dist < best_dist) {
+            best = i;
+            best_dist = dist;
+        }
+    }
+    return best;
+}
+
+void lcd_palette_set(uint8_t index, uint16_t color) {
+    if (index >= palette_used || palette_wire[index] == LCD_WIRE(color)) return;
+    palette_wire[index] = LCD_WIRE(color);
+    palette_dirty = true;
+}
+
+// Clip a rect against index_clip; false when nothing is left
+static bool index_clip_rect(int *x, int *y, int *w, int *h) {
+    int x0 = (*x > index_clip.x0) ? *x : index_clip.x0;
+    int y0 = (*y > index_clip.y0) ? *y : index_clip.y0;
+    int x1 = (*x + *w < index_clip.x1) ? *x + *w : index_clip.x1;
+    int y1 = (*y + *h < index_clip.y1) ? *y + *h : index_clip.y1;
+    if (x0 >= x1 || y0 >= y1) return false;
+    *x = x0;
+    *y = y0;
+    *w = x1 - x0;
+    *h = y1 - y0;
+    return true;
+}
+
+// Drawing outside the render pass only needs sending, not re-rendering, so
+// it is tracked apart from the dirty list
+static void index_touch(int x, int y, int w, int h) {
+    if (index_rendering) return;
+    
+    dirty_rect_t r = {x, y, x + w, y + h};
+    if (index_touched.x0 >= index_touched.x1) {
+        index_touched = r;
+    } else {
+        index_touched = rect_union(&index_touched, &r);
+    }
+}
+
+static void index_fill(int x, int y, int w, int h, uint16_t color) {
+    if (!index_clip_rect(&x, &y, &w, &h)) return;
+    
+    uint8_t idx = lcd_palette_index(color);
+    for (int row = y; row < y + h; row++) {
+        memset(index_fb + row * LCD_WIDTH + x, idx, w);
+    }
+    index_touch(x, y, w, h);
+}
+
+static void index_text(int x, int y, const char *str, int n, uint16_t color, uint16_t bg) {
+    int cx = x;
+    int cy = y;
+    int cw = n * LCD_GLYPH_SIZE;
+    int ch = LCD_GLYPH_SIZE;
+    if (!index_clip_rect(&cx, &cy, &cw, &ch)) return;
+    
+    uint8_t fg_idx = lcd_palette_index(color);
+    uint8_t bg_idx = lcd_palette_index(bg);
+    for (int py = cy; py < cy + ch; py++) {
+        uint8_t *dst = index_fb + py * LCD_WIDTH;
+        int row = (py - y) / LCD_FONT_SCALE;
+        for (int px = cx; px < cx + cw; px++) {
+            int col = (px - x) / LCD_FONT_SCALE;
+            char c = str[col / 8];
+            if (c < 32 || c > 127) c = 32;
+            int idx = c - 32;
+            uint8_t line = (idx < 96) ? font8x8[idx][row] : 0;
+            dst[px] = (line & (1 << (col % 8))) ? fg_idx : bg_idx;
+        }
+    }
+    index_touch(cx, cy, cw, ch);
+}
+
+esp_err_t lcd_set_indexed(bool enable) {
+    if (!enable) {
+        heap_caps_free(index_fb);
+        index_fb = NULL;
+        return ESP_OK;
+    }
+    if (index_fb != NULL) return ESP_OK;
+    
+    index_fb = heap_caps_malloc(LCD_WIDTH * LCD_HEIGHT, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (index_fb == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %d byte index framebuffer", LCD_WIDTH * LCD_HEIGHT);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Entry 0 is black so a cleared frame is black
+    palette_used = 0;
+    palette_last = 0;
+    lcd_palette_index(0x0000);
+    memset(index_fb, 0, LCD_WIDTH * LCD_HEIGHT);
+    index_clip = (dirty_rect_t){0, 0, LCD_WIDTH, LCD_HEIGHT};
+    index_rendering = false;
+    index_touched = (dirty_rect_t){0, 0, 0, 0};
+    palette_dirty = true;
+    
+    ESP_LOGI(TAG, "Indexed mode enabled (%d byte frame)", LCD_WIDTH * LCD_HEIGHT);
+    return ESP_OK;
+}
+
+// Drawing calls are recorded rather than drawn while the render callback
+// runs for the display list, unless lcd_render_to has redirected them
+static inline bool dl_capture(void) {
+    return dl_recording && target.buf == NULL;
+}
+
+// Append a command covering x, y, w, h; off-screen draws are dropped here
+static dl_cmd_t *dl_record(dl_kind_t kind, int x, int y, int w, int h, bool opaque) {
+    dirty_rect_t box = {x, y, x + w, y + h};
+    if (box.x0 < 0) box.x0 = 0;
+    if (box.y0 < 0) box.y0 = 0;
+    if (box.x1 > LCD_WIDTH) box.x1 = LCD_WIDTH;
+    if (box.y1 > LCD_HEIGHT) box.y1 = LCD_HEIGHT;
+    if (box.x0 >= box.x1 || box.y0 >= box.y1) return NULL;
+    if (dl_count == LCD_DL_COMMANDS) {
+        dl_overflow = true;
+        return NULL;
+    }
+    
+    dl_cmd_t *c = &dl_cmds[dl_count++];
+    c->box = box;
+    c->kind = kind;
+    c->opaque = opaque;
+    c->x = x;
+    c->y = y;
+    c->w = w;
+    c->h = h;
+    return c;
+}
+
+static void dl_record_text(int x, int y, const char *str, int n, uint16_t color, uint16_t bg) {
+    if (n == 0) return;
+    if (dl_text_used + n > LCD_DL_TEXT) {
+        dl_overflow = true;
+        return;
+    }
+    // Same fg and bg draws the set bits only, so the box is not covered
+    dl_cmd_t *c = dl_record(DL_TEXT, x, y, n * LCD_GLYPH_SIZE, LCD_GLYPH_SIZE, bg != color);
+    if (c == NULL) return;
+    memcpy(dl_text + dl_text_used, str, n);
+    c->data = dl_text + dl_text_used;
+    c->len = n;
+    c->color = color;
+    c->bg = bg;
+    dl_text_used += n;
+}
+
+void lcd_draw_pixel(int x, int y, uint16_t color) {
+    if (target.buf) {
+        if (x >= target.x && x < target.x + target.w &&
+            y >= target.y && y < target.y + target.h) {
+            target.buf[(y - target.y) * target.w + (x - target.x)] = LCD_WIRE(color);
+        }
+        return;
+    }
+    if (dl_capture()) {
+        dl_cmd_t *c = dl_record(DL_RECT, x, y, 1, 1, true);
+        if (c != NULL) c->color = color;
+        return;
+    }
+    if (index_fb) {
+        index_fill(x, y, 1, 1, color);
+        return;
+    }
+    if (x < 0 || x >= LCD_WIDTH || y < 0 || y >= LCD_HEIGHT) return;
+    uint16_t c = LCD_WIRE(color);
+    lcd_write_rect(x, y, 1, 1, &c);
+}
+
+void lcd_fill_rect(int x, int y, int w, int h, uint16_t color) {
+    if (target.buf) {
+        target_fill(x, y, w, h, color);
+        return;
+    }
+    if (dl_capture()) {
+        dl_cmd_t *c = dl_record(DL_RECT, x, y, w, h, true);
+        if (c != NULL) c->color = color;
+        return;
+    }
+    if (index_fb) {
+        index_fill(x, y, w, h, color);
+        return;
+    }
+    if (x < 0 || x >= LCD_WIDTH || y < 0 || y >= LCD_HEIGHT) return;
+    if (x + w > LCD_WIDTH) w = LCD_WIDTH - x;
+    if (y + h > LCD_HEIGHT) h = LCD_HEIGHT - y;
+    if (w <= 0 || h <= 0) return;
+    
+    shadow_write(x, y, w, h, NULL, 0, LCD_WIRE(color));
+    for (int row = 0; row < h; ) {
+        int gram;
+        int n = gram_rows(y + row, h - row, &gram);
+        lcd_set_window(x, gram, x+w-1, gram+n-1);
+        stats.fill_transactions += lcd_fill_pixels(color, (uint32_t)w * n);
+        row += n;
+    }
+    stats.fill_calls++;
+    stats.fill_legacy_transactions += (uint32_t)w * h;
+}
+
+// lcd_fill_rect drops rects that start off-screen, so shapes clip here first
+static void fill_clipped(int x, int y, int w, int h, uint16_t color) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (w <= 0 || h <= 0) return;
+    lcd_fill_rect(x, y, w, h, color);
+}
+
+void lcd_draw_rect(int x, int y, int w, int h, uint16_t color) {
+    if (w <= 0 || h <= 0) return;
+    
+    // Top and bottom
+    fill_clipped(x, y, w, 1, color);
+    if (h > 1) fill_clipped(x, y + h - 1, w, 1, color);
+    // Left and right, between the horizontal edges
+    fill_clipped(x, y + 1, 1, h - 2, color);
+    if (w > 1) fill_clipped(x + w - 1, y + 1, 1, h - 2, color);
+}
+
+// Emit one run of outline points that share the same x offset (y offsets
+// ys..ye) in all eight octants: vertical runs on the sides of the circle,
+// horizontal runs at the top and bottom
+static void circle_run(int x0, int y0, int x, int ys, int ye, uint16_t color) {
+    int len = ye - ys + 1;
+    fill_clipped(x0 + x, y0 + ys, 1, len, color);
+    fill_clipped(x0 - x, y0 + ys, 1, len, color);
+    fill_clipped(x0 + x, y0 - ye, 1, len, color);
+    fill_clipped(x0 - x, y0 - ye, 1, len, color);
+    fill_clipped(x0 + ys, y0 + x, len, 1, color);
+    fill_clipped(x0 - ye, y0 + x, len, 1, color);
+    fill_clipped(x0 + ys, y0 - x, len, 1, color);
+    fill_clipped(x0 - ye, y0 - x, len, 1, color);
+}
+
+void lcd_draw_circle(int x0, int y0, int radius, uint16_t color) {
+    if (dl_capture()) {
+        dl_cmd_t *c = dl_record(DL_CIRCLE, x0 - radius, y0 - radius,
+                                2 * radius + 1, 2 * radius + 1, false);
+        if (c != NULL) {
+            c->x = x0;
+            c->y = y0;
+            c->w = radius;
+            c->color = color;
+        }
+        return;
+    }
+    int x = radius;
+    int y = 0;
+    int err = 0;
+    // Outline points are collected into runs of constant x
+    int run_x = x;
+    int run_y0 = 0;
+    int run_y1 = -1;
+    
+    while (x >= y) {
+        if (x != run_x) {
+            circle_run(x0, y0, run_x, run_y0, run_y1, color);
+            run_x = x;
+            run_y0 = y;
+        }
+        run_y1 = y;
+        
+        if (err <= 0) {
+            y += 1;
+            err += 2*y + 1;
+        }
+        if (err > 0) {
+            x -= 1;
+            err -= 2*x + 1;
+        }
+    }
+    if (run_y1 >= run_y0) {
+        circle_run(x0, y0, run_x, run_y0, run_y1, color);
+    }
+}
+
+void lcd_fill_circle(int x0, int y0, int radius, uint16_t color) {
+    if (dl_capture()) {
+        dl_cmd_t *c = dl_record(DL_FILL_CIRCLE, x0 - radius, y0 - radius,
+                                2 * radius + 1, 2 * radius + 1, false);
+        if (c != NULL) {
+            c->x = x0;
+            c->y = y0;
+            c->w = radius;
+            c->color = color;
+        }
+        return;
+    }
+    // One span per row; the half width only shrinks moving away from the centre
+    int x = radius;
+    for (int y = 0; y <= radius; y++) {
+        while (x*x + y*y > radius*radius) {
+            x--;
+        }
+        fill_clipped(x0 - x, y0 + y, 2*x + 1, 1, color);
+        if (y > 0) {
+            fill_clipped(x0 - x, y0 - y, 2*x + 1, 1, color);
+        }
+    }
+}
+
+// Return the glyph for `c` as LCD_GLYPH_SIZE rows of wire-order pixels
+static const uint16_t *glyph_get(char c, uint16_t color, uint16_t bg) {
+    if (c < 32 || c > 127) c = 32;
+    
+    for (int i = 0; i < LCD_GLYPH_CACHE; i++) {
+        glyph_tag_t *tag = &glyph_tags[i];
+        if (tag->valid && tag->c == c && tag->fg == color && tag->bg == bg) {
+            stats.glyph_hits++;
+            return glyph_pixels + i * LCD_GLYPH_PIXELS;
+        }
+    }
+    
+    int slot = glyph_next;
+    glyph_next = (glyph_next + 1) % LCD_GLYPH_CACHE;
+    glyph_tags[slot] = (glyph_tag_t){.fg = color, .bg = bg, .c = c, .valid = true};
+    stats.glyph_misses++;
+    
+    int idx = c - 32;
+    uint16_t fg_wire = LCD_WIRE(color);
+    uint16_t bg_wire = LCD_WIRE(bg);
+    uint16_t *p = glyph_pixels + slot * LCD_GLYPH_PIXELS;
+    for (int row = 0; row < LCD_GLYPH_SIZE; row++) {
+        uint8_t line = (idx < 96) ? font8x8[idx][row / LCD_FONT_SCALE] : 0;
+        for (int col = 0; col < LCD_GLYPH_SIZE; col++) {
+            *p++ = (line & (1 << (col / LCD_FONT_SCALE))) ? fg_wire : bg_wire;
+        }
+    }
+    return glyph_pixels + slot * LCD_GLYPH_PIXELS;
+}
+
+// Copy `n` glyphs starting at (x, y) into `buf`, which covers the screen
+// area bx..bx+bw-1, by..by+bh-1; anything outside it is clipped
+static void text_blit(uint16_t *buf, int bx, int by, int bw, int bh,
+                      int x, int y, const char *str, int n, uint16_t color, uint16_t bg) {
+    int y0 = (y > by) ? y : by;
+    int y1 = (y + LCD_GLYPH_SIZE < by + bh) ? y + LCD_GLYPH_SIZE : by + bh;
+    if (y0 >= y1) return;
+    
+    for (int i = 0; i < n; i++, x += LCD_GLYPH_SIZE) {
+        int x0 = (x > bx) ? x : bx;
+        int x1 = (x + LCD_GLYPH_SIZE < bx + bw) ? x + LCD_GLYPH_SIZE : bx + bw;
+        if (x0 >= x1) continue;
+        
+        const uint16_t *glyph = glyph_get(str[i], color, bg);
+        for (int row = y0; row < y1; row++) {
+            memcpy(buf + (row - by) * bw + (x0 - bx),
+                   glyph + (row - y) * LCD_GLYPH_SIZE + (x0 - x),
+                   (x1 - x0) * sizeof(uint16_t));
+        }
+    }
+}
+
+// Draw a row of `n` characters with one window and one transfer
+static void lcd_draw_text(int x, int y, const char *str, int n, uint16_t color, uint16_t bg) {
+    if (target.buf) {
+        text_blit(target.buf, target.x, target.y, target.w, target.h,
+                  x, y, str, n, color, bg);
+        return;
+    }
+    if (index_fb) {
+        index_text(x, y, str, n, color, bg);
+        return;
+    }
+    
+    int x0 = (x > 0) ? x : 0;
+    int y0 = (y > 0) ? y : 0;
+    int x1 = (x + n * LCD_GLYPH_SIZE < LCD_WIDTH) ? x + n * LCD_GLYPH_SIZE : LCD_WIDTH;
+    int y1 = (y + LCD_GLYPH_SIZE < LCD_HEIGHT) ? y + LCD_GLYPH_SIZE : LCD_HEIGHT;
+    if (x0 >= x1 || y0 >= y1) return;
+    int w = x1 - x0;
+    int h = y1 - y0;
+    
+    if (n == 1 && w == LCD_GLYPH_SIZE && h == LCD_GLYPH_SIZE) {
+        // A whole glyph can go straight out of the cache
+        const uint16_t *glyph = glyph_get(str[0], color, bg);
+        lcd_write_rect(x0, y0, w, h, glyph);
+        return;
+    }
+    
+    // Longer runs are composed in a strip buffer; a row of text is at most
+    // LCD_WIDTH x LCD_GLYPH_SIZE pixels, which always fits
+    lcd_wait_idle();
+    text_blit(strip_buf[0], x0, y0, w, h, x, y, str, n, color, bg);
+    lcd_write_rect(x0, y0, w, h, strip_buf[0]);
+}
+
+void lcd_draw_char(int x, int y, char c, uint16_t color, uint16_t bg) {
+    if (dl_capture()) {
+        dl_record_text(x, y, &c, 1, color, bg);
+        return;
+    }
+    if (bg != color) {
+        lcd_draw_text(x, y, &c, 1, color, bg);
+        return;
+    }
+    
+    // Same fg and bg means a transparent background: plot the set bits only
+    if (c < 32 || c > 127) c = 32;
+    int idx = c - 32;
+    for (int row = 0; row < 8; row++) {
+        uint8_t line = (idx < 96) ? font8x8[idx][row] : 0;
+        for (int col = 0; col < 8; col++) {
+            if (line & (1 << col)) {
+                fill_clipped(x + col * LCD_FONT_SCALE, y + row * LCD_FONT_SCALE,
+                             LCD_FONT_SCALE, LCD_FONT_SCALE, color);
+            }
+        }
+    }
+}
+
+void lcd_draw_string(int x, int y, const char* str, uint16_t color, uint16_t bg) {
+    if (dl_capture()) {
+        dl_record_text(x, y, str, strlen(str), color, bg);
+        return;
+    }
+    if (bg != color) {
+        lcd_draw_text(x, y, str, strlen(str), color, bg);
+        return;
+    }
+    
+    int cx = x;
+    while (*str) {
+        lcd_draw_char(cx, y, *str++, color, bg);
+        cx += LCD_GLYPH_SIZE;
+    }
+}
+
+void lcd_draw_number(int x, int y, uint32_t num, uint16_t color, uint16_t bg) {
+    char buf[12];
+    snprintf(buf, sizeof(buf), "%lu", (unsigned long)num);
+    lcd_draw_string(x, y, buf, color, bg);
+}
+
+void lcd_write_data_buffer(const uint16_t* data, uint32_t len) {
+    // The window is unknown here, so the whole shadow may be wrong now
+    shadow_forget(0, 0, LCD_WIDTH, LCD_HEIGHT);
+    lcd_wait_idle();
+    // Convert to bytes and send
+    uint8_t* byte_data = (uint8_t*)data;
+    spi_transaction_t t = {.length = len * 16, .tx_buffer = byte_data, .user = (void*)1};
+    spi_device_polling_transmit(spi, &t);
+    stats.transactions++;
+    stats.bytes += len * 2;
+}
+
+void lcd_render_to(uint16_t *buf, int w, int h, lcd_render_fn_t fn, void *arg) {
+    // Save the current target so this also works from inside a render pass
+    draw_target_t saved = target;
+    
+    memset(buf, 0, w * h * sizeof(uint16_t));
+    target.buf = buf;
+    target.x = 0;
+    target.y = 0;
+    target.w = w;
+    target.h = h;
+    fn(arg);
+    target = saved;
+}
+
+// Clip [x0, x1) x [y0, y1) to wherever drawing currently goes. Returns
+// false when nothing is left.
+static bool draw_clip(int *x0, int *y0, int *x1, int *y1) {
+    int cx0 = 0, cy0 = 0, cx1 = LCD_WIDTH, cy1 = LCD_HEIGHT;
+    if (target.buf) {
+        cx0 = target.x;
+        cy0 = target.y;
+        cx1 = target.x + target.w;
+        cy1 = target.y + target.h;
+    } else if (index_fb) {
+        cx0 = index_clip.x0;
+        cy0 = index_clip.y0;
+        cx1 = index_clip.x1;
+        cy1 = index_clip.y1;
+    }
+    if (*x0 < cx0) *x0 = cx0;
+    if (*y0 < cy0) *y0 = cy0;
+    if (*x1 > cx1) *x1 = cx1;
+    if (*y1 > cy1) *y1 = cy1;
+    return *x0 < *x1 && *y0 < *y1;
+}
+
+void lcd_draw_bitmap(int x, int y, int w, int h, const uint16_t *pixels) {
+    if (dl_capture()) {
+        dl_cmd_t *c = dl_record(DL_BITMAP, x, y, w, h, true);
+        if (c != NULL) c->data = pixels;
+        return;
+    }
+    int x0 = x;
+    int y0 = y;
+    int x1 = x + w;
+    int y1 = y + h;
+    if (!draw_clip(&x0, &y0, &x1, &y1)) return;
+    
+    if (target.buf) {
+        for (int row = y0; row < y1; row++) {
+            memcpy(target.buf + (row - target.y) * target.w + (x0 - target.x),
+                   pixels + (row - y) * w + (x0 - x),
+                   (x1 - x0) * sizeof(uint16_t));
+        }
+        return;
+    }
+    if (index_fb) {
+        // LCD_WIRE is its own inverse, so it also turns wire order back into a color
+        for (int row = y0; row < y1; row++) {
+            const uint16_t *src = pixels + (row - y) * w + (x0 - x);
+            uint8_t *dst = index_fb + row * LCD_WIDTH;
+            for (int col = x0; col < x1; col++) {
+                uint16_t wire = *src++;
+                dst[col] = lcd_palette_index(LCD_WIRE(wire));
+            }
+        }
+        index_touch(x0, y0, x1 - x0, y1 - y0);
+        return;
+    }
+    
+    // Rows are contiguous only when nothing was clipped horizontally
+    if (x0 == x && x1 == x + w) {
+        lcd_write_rect(x0, y0, w, y1 - y0, pixels + (y0 - y) * w);
+        return;
+    }
+    for (int row = y0; row < y1; row++) {
+        lcd_write_rect(x0, row, x1 - x0, 1, pixels + (row - y) * w + (x0 - x));
+    }
+}
+
+// Draw one sprite run of n pixels starting at (x, row), already clipped.
+// A fill run repeats colors[0], any other run reads n colors.
+static void sprite_run(int x, int row, int n, const uint16_t *colors, bool fill) {
+    if (target.buf) {
+        uint16_t *dst = target.buf + (row - target.y) * target.w + (x - target.x);
+        for (int i = 0; i < n; i++) {
+            uint16_t color = colors[fill ? 0 : i];
+            dst[i] = LCD_WIRE(color);
+        }
+    } else if (index_fb) {
+        uint8_t *dst = index_fb + row * LCD_WIDTH + x;
+        if (fill) {
+            memset(dst, lcd_palette_index(colors[0]), n);
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            dst[i] = lcd_palette_index(colors[i]);
+        }
+    } else if (fill) {
+        lcd_fill_rect(x, row, n, 1, colors[0]);
+    } else {
+        // Outside a render pass each run is its own window
+        uint16_t wire[LCD_SPRITE_COUNT];
+        for (int i = 0; i < n; i++) {
+            uint16_t color = colors[i];
+            wire[i] = LCD_WIRE(color);
+        }
+        lcd_write_rect(x, row, n, 1, wire);
+    }
+}
+
+void lcd_draw_sprite(int x, int y, const lcd_sprite_t *sprite) {
+    if (dl_capture()) {
+        dl_cmd_t *c = dl_record(DL_SPRITE, x, y, sprite->width, sprite->height, false);
+        if (c != NULL) c->data = sprite;
+        return;
+    }
+    int x0 = x;
+    int y0 = y;
+    int x1 = x + sprite->width;
+    int y1 = y + sprite->height;
+    if (!draw_clip(&x0, &y0, &x1, &y1)) return;
+    
+    // Rows have no index, so rows above the clip are walked to find the start
+    const uint16_t *p = sprite->data;
+    for (int row = y; row < y1; row++) {
+        int col = x;
+        for (uint16_t run; (run = *p++) != 0; ) {
+            int n = run & LCD_SPRITE_COUNT;
+            bool fill = run & LCD_SPRITE_FILL;
+            col += run >> 8;
+            if (row >= y0) {
+                int c0 = col < x0 ? x0 : col;
+                int c1 = col + n > x1 ? x1 : col + n;
+                if (c0 < c1) {
+                    sprite_run(c0, row, c1 - c0, fill ? p : p + (c0 - col), fill);
+                }
+            }
+            p += fill ? 1 : n;
+            col += n;
+        }
+    }
+    if (index_fb && !target.buf) {
+        index_touch(x0, y0, x1 - x0, y1 - y0);
+    }
+}
+
+static void lcd_send_scroll_start(void) {
+    uint16_t vsp = scroll_top + scroll_offset;
+    uint8_t data[2] = {vsp >> 8, vsp & 0xFF};
+    lcd_cmd(CMD_VSCRSADD);
+    lcd_data(data, 2);
+}
+
+esp_err_t lcd_scroll_region(int top, int height) {
+    if (top < 0 || height < 0 || top + height > LCD_HEIGHT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (scroll_offset != 0) {
+        // The old band reads straight again once the offset is dropped
+        lcd_invalidate(0, scroll_top, LCD_WIDTH, scroll_height);
+        shadow_forget(0, scroll_top, LCD_WIDTH, scroll_top + scroll_height);
+    }
+    
+    // VSCRDEF takes the fixed top, scrolling and fixed bottom heights, which
+    // must cover the whole panel; no band is the same as one unscrolled band
+    scroll_top = (height > 0) ? top : 0;
+    scroll_height = height;
+    scroll_offset = 0;
+    uint16_t vsa = (height > 0) ? height : LCD_HEIGHT;
+    uint16_t bfa = LCD_HEIGHT - scroll_top - vsa;
+    uint8_t data[6] = {
+        scroll_top >> 8, scroll_top & 0xFF,
+        vsa >> 8, vsa & 0xFF,
+        bfa >> 8, bfa & 0xFF,
+    };
+    lcd_cmd(CMD_VSCRDEF);
+    lcd_data(data, 6);
+    lcd_send_scroll_start();
+    return ESP_OK;
+}
+
+void lcd_scroll(int dy) {
+    if (scroll_height == 0 || dy == 0) return;
+    
+    int h = scroll_height;
+    scroll_offset = ((scroll_offset + dy) % h + h) % h;
+    lcd_send_scroll_start();
+    stats.scrolls++;
+    
+    int n = (abs(dy) < h) ? abs(dy) : h;
+    if (index_fb) {
+        // Keep the indexed frame in step with the panel. Anything drawn but
+        // not yet sent moved with it, so the whole band goes out instead.
+        uint8_t *band = index_fb + scroll_top * LCD_WIDTH;
+        if (n < h) {
+            if (dy > 0) {
+                memmove(band, band + n * LCD_WIDTH, (h - n) * LCD_WIDTH);
+            } else {
+                memmove(band + n * LCD_WIDTH, band, (h - n) * LCD_WIDTH);
+            }
+        }
+        if (index_touched.x0 < index_touched.x1) {
+            index_touch(0, scroll_top, LCD_WIDTH, h);
+        }
+    }
+    
+    // Rows that scrolled in still hold what scrolled out the other side
+    lcd_invalidate(0, (dy > 0) ? scroll_top + h - n : scroll_top, LCD_WIDTH, n);
+    shadow_forget(0, scroll_top, LCD_WIDTH, scroll_top + h);
+}
+
+void lcd_set_renderer(lcd_render_fn_t fn, void *arg) {
+    render_fn = fn;
+    render_arg = arg;
+}
+
+esp_err_t lcd_set_shadow(int x, int y, int w, int h) {
+    if (w == 0 || h == 0) {
+        heap_caps_free(shadow_buf);
+        shadow_buf = NULL;
+        return ESP_OK;
+    }
+    if (x < 0 || y < 0 || w < 0 || h < 0 || x + w > LCD_WIDTH || y + h > LCD_HEIGHT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    for (int i = 0; i < 2; i++) {
+        if (pack_buf[i] != NULL) continue;
+        pack_buf[i] = heap_caps_malloc(LCD_MAX_TRANSFER, MALLOC_CAP_DMA);
+        if (pack_buf[i] == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate %d byte pack buffer", LCD_MAX_TRANSFER);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    heap_caps_free(shadow_buf);
+    shadow_buf = heap_caps_malloc(w * h * sizeof(uint16_t), MALLOC_CAP_8BIT);
+    if (shadow_buf == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %d byte shadow", w * h * 2);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Nothing is known about the panel yet
+    shadow_area = (dirty_rect_t){x, y, x + w, y + h};
+    shadow_stale = (dirty_rect_t){0, 0, 0, 0};
+    shadow_forget(x, y, x + w, y + h);
+    
+    ESP_LOGI(TAG, "Shadow enabled for %dx%d at %d,%d", w, h, x, y);
+    return ESP_OK;
+}
+
+// Merge when the rects overlap, or when they touch and their union wastes no
+// more pixels than it saves in window setup (e.g. neighbouring tiles)
+static bool rect_try_merge(dirty_rect_t *a, const dirty_rect_t *b) {
+    if (a->x0 > b->x1 || b->x0 > a->x1 || a->y0 > b->y1 || b->y0 > a->y1) {
+        return false;
+    }
+    dirty_rect_t u = rect_union(a, b);
+    bool overlap = a->x0 < b->x1 && b->x0 < a->x1 && a->y0 < b->y1 && b->y0 < a->y1;
+    if (!overlap && rect_area(&u) > rect_area(a) + rect_area(b)) {
+        return false;
+    }
+    *a = u;
+    return true;
+}
+
+static dirty_rect_t dirty_bounds(void) {
+    dirty_rect_t box = dirty[0];
+    for (int i = 1; i < dirty_count; i++) {
+        box = rect_union(&box, &dirty[i]);
+    }
+    return box;
+}
+
+// Replace the whole list with its bounding box
+static void dirty_collapse(void) {
+    dirty[0] = dirty_bounds();
+    dirty_count = 1;
+    dirty_collapsed = true;
+}
+
+void lcd_invalidate(int x, int y, int w, int h) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > LCD_WIDTH) w = LCD_WIDTH - x;
+    if (y + h > LCD_HEIGHT) h = LCD_HEIGHT - y;
+    if (w <= 0 || h <= 0) return;
+    
+    dirty_rect_t r = {.x0 = x, .y0 = y, .x1 = x + w, .y1 = y + h};
+    
+    // Absorb every rect the new one merges with; repeat since the grown
+    // rect may now reach rects it missed on the previous pass
+    bool merged;
+    do {
+        merged = false;
+        for (int i = 0; i < dirty_count; i++) {
+            if (rect_try_merge(&r, &dirty[i])) {
+                dirty[i] = dirty[--dirty_count];
+                merged = true;
+                i--;
+            }
+        }
+    } while (merged);
+    
+    if (dirty_count == LCD_MAX_DIRTY_RECTS) {
+        dirty_collapse();
+        dirty[0] = rect_union(&dirty[0], &r);
+        return;
+    }
+    dirty[dirty_count++] = r;
+    
+    // Too fragmented: once the pieces cover most of their bounding box,
+    // one box costs fewer window setups than the extra pixels it adds
+    if (dirty_count > 1) {
+        int sum = 0;
+        for (int i = 0; i < dirty_count; i++) {
+            sum += rect_area(&dirty[i]);
+        }
+        dirty_rect_t box = dirty_bounds();
+        if (sum * 4 >= rect_area(&box) * 3) {
+            dirty_collapse();
+        }
+    }
+}
+
+uint16_t *lcd_strip_acquire(void) {
+    // This buffer's previous strip must be off the wire before it is
+    // reused; the other buffer keeps transmitting meanwhile
+    lcd_reap_until(strip_seq[strip_slot]);
+    return strip_buf[strip_slot];
+}
+
+// First index from i on where rows a and b differ, comparing pixel pairs
+// while both rows are word aligned
+static int skip_equal(const uint16_t *a, const uint16_t *b, int i, int n) {
+    if ((((uintptr_t)(a + i) ^ (uintptr_t)(b + i)) & 3) == 0) {
+        if (((uintptr_t)(a + i) & 3) != 0) {
+            if (i >= n || a[i] != b[i]) return i;
+            i++;
+        }
+        const pixel_pair_t *pa = (const pixel_pair_t *)(a + i);
+        const pixel_pair_t *pb = (const pixel_pair_t *)(b + i);
+        while (i + 2 <= n && *pa == *pb) {
+            pa++;
+            pb++;
+            i += 2;
+        }
+    }
+    while (i < n && a[i] == b[i]) i++;
+    return i;
+}
+
+// Changed spans of a row as [start, end) pairs. Gaps shorter than
+// LCD_SHADOW_GAP are sent rather than split on; past LCD_SHADOW_SPANS the
+// last span grows to cover the rest.
+static int row_spans(const uint16_t *a, const uint16_t *b, int n, int16_t spans[][2]) {
+    int count = 0;
+    int i = skip_equal(a, b, 0, n);
+    while (i < n) {
+        int end = i;
+        int next;
+        for (;;) {
+            while (end < n && a[end] != b[end]) end++;
+            next = skip_equal(a, b, end, n);
+            if (next >= n || next - end >= LCD_SHADOW_GAP) break;
+            end = next;
+        }
+        if (count == LCD_SHADOW_SPANS) {
+            spans[count - 1][1] = end;
+        } else {
+            spans[count][0] = i;
+            spans[count][1] = end;
+            count++;
+        }
+        i = next;
+    }
+    return count;
+}
+
+// Diff a strip that lies inside the shadow area against it. Rows with the
+// same spans are grouped into rects. Returns the rect count, or -1 when the
+// window setups would cost more than sending the strip whole.
+static int shadow_diff(int x, int y, int w, int h, const uint16_t *buf, dirty_rect_t *rects) {
+    int sw = shadow_area.x1 - shadow_area.x0;
+    const uint16_t *old = shadow_buf + (y - shadow_area.y0) * sw + (x - shadow_area.x0);
+    int16_t spans[2][LCD_SHADOW_SPANS][2];
+    int count[2] = {0, 0};
+    int cur = 0;
+    int group = 0;     // First row of the group ending at the previous row
+    int nrects = 0;
+    int cost = 0;
+    
+    for (int row = 0; row <= h; row++) {
+        int next = cur ^ 1;
+        count[next] = (row < h) ? row_spans(buf + row * w, old + row * sw, w, spans[next]) : 0;
+        bool same = row > 0 && row < h && count[next] == count[cur] &&
+                    memcmp(spans[next], spans[cur], count[cur] * sizeof(spans[0][0])) == 0;
+        if (row > 0 && !same) {
+            // Close the group that ended on the previous row
+            if (nrects + count[cur] > LCD_SHADOW_RECTS) return -1;
+            for (int i = 0; i < count[cur]; i++) {
+                dirty_rect_t *r = &rects[nrects++];
+                r->x0 = x + spans[cur][i][0];
+                r->x1 = x + spans[cur][i][1];
+                r->y0 = y + group;
+                r->y1 = y + row;
+                cost += rect_area(r) + LCD_SHADOW_GAP;
+            }
+            group = row;
+        }
+        if (!same) cur = next;
+    }
+    return (cost < w * h) ? nrects : -1;
+}
+
+// Queue the acquired buffer for the area at x, y behind its window setup.
+// It stays owned by the SPI driver until strip_seq[slot] is reaped.
+void lcd_strip_submit(int x, int y, int w, int h) {
+    int slot = strip_slot;
+    strip_slot ^= 1;
+    
+    dirty_rect_t strip = {x, y, x + w, y + h};
+    bool inside = shadow_buf != NULL &&
+                  x >= shadow_area.x0 && x + w <= shadow_area.x1 &&
+                  y >= shadow_area.y0 && y + h <= shadow_area.y1;
+    dirty_rect_t rects[LCD_SHADOW_RECTS];
+    int nrects = -1;
+    if (inside && !rect_overlap(&strip, &shadow_stale)) {
+        nrects = shadow_diff(x, y, w, h, strip_buf[slot], rects);
+    }
+    shadow_write(x, y, w, h, strip_buf[slot], w, 0);
+    
+    if (nrects < 0) {
+        lcd_queue_rect(x, y, w, h, strip_buf[slot]);
+    } else {
+        // Full-width rects are contiguous in the strip; others are packed
+        uint16_t *pack = pack_buf[slot];
+        int sent = 0;
+        for (int i = 0; i < nrects; i++) {
+            int rw = rects[i].x1 - rects[i].x0;
+            int rh = rects[i].y1 - rects[i].y0;
+            const uint16_t *src = strip_buf[slot] + (rects[i].y0 - y) * w + (rects[i].x0 - x);
+            if (rw < w) {
+                for (int row = 0; row < rh; row++) {
+                    memcpy(pack + row * rw, src + row * w, rw * sizeof(uint16_t));
+                }
+                src = pack;
+                pack += rw * rh;
+            }
+            lcd_queue_rect(rects[i].x0, rects[i].y0, rw, rh, src);
+            sent += rw * rh;
+        }
+        frame_stats.unchanged += w * h - sent;
+    }
+    strip_seq[slot] = queued_seq;
+    
+    stats.strips++;
+    frame_stats.pixels += w * h;
+}
+
+void lcd_strip_finish(void) {
+    lcd_wait_idle();
+}
+
+// Run the render callback once with drawing recorded, then bin the commands.
+// Returns false if the frame did not fit and has to be rendered per strip.
+static bool dl_build(void) {
+    dl_count = 0;
+    dl_text_used = 0;
+    dl_overflow = false;
+    dl_recording = true;
+    render_fn(render_arg);
+    dl_recording = false;
+    
+    uint16_t count[LCD_DL_BINS] = {0};
+    int total = 0;
+    for (int i = 0; i < dl_count && !dl_overflow; i++) {
+        for (int b = dl_cmds[i].box.y0 / LCD_DL_BIN_ROWS; b * LCD_DL_BIN_ROWS < dl_cmds[i].box.y1; b++) {
+            count[b]++;
+            total++;
+        }
+        dl_overflow = total > LCD_DL_ENTRIES;
+    }
+    if (dl_overflow) {
+        stats.dl_overflows++;
+        ESP_LOGD(TAG, "Display list full (%d commands), rendering per strip", dl_count);
+        return false;
+    }
+    
+    // Counting sort: each bin lists its commands in recording order
+    dl_bin_start[0] = 0;
+    for (int b = 0; b < LCD_DL_BINS; b++) {
+        dl_bin_start[b + 1] = dl_bin_start[b] + count[b];
+        count[b] = dl_bin_start[b];
+    }
+    for (int i = 0; i < dl_count; i++) {
+        for (int b = dl_cmds[i].box.y0 / LCD_DL_BIN_ROWS; b * LCD_DL_BIN_ROWS < dl_cmds[i].box.y1; b++) {
+            dl_entries[count[b]++] = i;
+        }
+    }
+    frame_stats.commands = dl_count;
+    return true;
+}
+
+static void dl_draw(const dl_cmd_t *c) {
+    switch (c->kind) {
+        case DL_RECT:
+            lcd_fill_rect(c->x, c->y, c->w, c->h, c->color);
+            break;
+        case DL_CIRCLE:
+            lcd_draw_circle(c->x, c->y, c->w, c->color);
+            break;
+        case DL_FILL_CIRCLE:
+            lcd_fill_circle(c->x, c->y, c->w, c->color);
+            break;
+        case DL_TEXT: {
+            const char *str = c->data;
+            if (c->bg != c->color) {
+                lcd_draw_text(c->x, c->y, str, c->len, c->color, c->bg);
+                break;
+            }
+            for (int i = 0; i < c->len; i++) {
+                lcd_draw_char(c->x + i * LCD_GLYPH_SIZE, c->y, str[i], c->color, c->bg);
+            }
+            break;
+        }
+        case DL_BITMAP:
+            lcd_draw_bitmap(c->x, c->y, c->w, c->h, c->data);
+            break;
+        case DL_SPRITE:
+            lcd_draw_sprite(c->x, c->y, c->data);
+            break;
+    }
+}
+
+static inline bool rect_contains(const dirty_rect_t *outer, const dirty_rect_t *r) {
+    return r->x0 >= outer->x0 && r->x1 <= outer->x1 && r->y0 >= outer->y0 && r->y1 <= outer->y1;
+}
+
+// Replay one bin's commands that touch seg, which the current target or
+// index clip is already limited to. Walking back to front, a command is
+// dropped when a later opaque one covers all of it that falls in seg.
+static void dl_replay_bin(int bin, const dirty_rect_t *seg) {
+    dirty_rect_t occluders[LCD_DL_OCCLUDERS];
+    int nocc = 0;
+    int n = 0;
+    
+    for (int i = dl_bin_start[bin + 1] - 1; i >= dl_bin_start[bin]; i--) {
+        const dl_cmd_t *c = &dl_cmds[dl_entries[i]];
+        if (!rect_overlap(&c->box, seg)) continue;
+        dirty_rect_t r = {
+            .x0 = (c->box.x0 > seg->x0) ? c->box.x0 : seg->x0,
+            .y0 = (c->box.y0 > seg->y0) ? c->box.y0 : seg->y0,
+            .x1 = (c->box.x1 < seg->x1) ? c->box.x1 : seg->x1,
+            .y1 = (c->box.y1 < seg->y1) ? c->box.y1 : seg->y1,
+        };
+        
+        bool hidden = false;
+        for (int k = 0; k < nocc && !hidden; k++) {
+            hidden = rect_contains(&occluders[k], &r);
+        }
+        if (hidden) {
+            frame_stats.culled++;
+            continue;
+        }
+        dl_visible[n++] = dl_entries[i];
+        
+        if (c->opaque) {
+            // Keep the largest occluders once the list is full
+            int k = nocc;
+            if (nocc == LCD_DL_OCCLUDERS) {
+                k = 0;
+                for (int j = 1; j < nocc; j++) {
+                    if (rect_area(&occluders[j]) < rect_area(&occluders[k])) k = j;
+                }
+                if (rect_area(&occluders[k]) >= rect_area(&r)) continue;
+            } else {
+                nocc++;
+            }
+            occluders[k] = r;
+        }
+    }
+    
+    while (n > 0) {
+        dl_draw(&dl_cmds[dl_visible[--n]]);
+        frame_stats.draws++;
+    }
+}
+
+// Draw the recorded frame over area: into the strip in target, or into the
+// index frame. Each bin the area spans is replayed with drawing clipped to
+// its rows, so commands from different bins never need ordering.
+static void dl_replay(const dirty_rect_t *area) {
+    draw_target_t strip = target;
+    for (int b = area->y0 / LCD_DL_BIN_ROWS; b * LCD_DL_BIN_ROWS < area->y1; b++) {
+        dirty_rect_t seg = *area;
+        if (seg.y0 < b * LCD_DL_BIN_ROWS) seg.y0 = b * LCD_DL_BIN_ROWS;
+        if (seg.y1 > (b + 1) * LCD_DL_BIN_ROWS) seg.y1 = (b + 1) * LCD_DL_BIN_ROWS;
+        
+        if (strip.buf) {
+            target.buf = strip.buf + (seg.y0 - strip.y) * strip.w;
+            target.y = seg.y0;
+            target.h = seg.y1 - seg.y0;
+        } else {
+            index_clip = seg;
+        }
+        dl_replay_bin(b, &seg);
+    }
+    target = strip;
+}
+
+// Indexed mode: re-render the dirty rects into the index frame, then send
+// them (or the whole frame after a palette change) through the LUT
+static void index_flush(void) {
+    if (render_fn != NULL && dirty_count > 0) {
+        bool recorded = dl_build();
+        index_rendering = true;
+        for (int i = 0; i < dirty_count; i++) {
+            index_clip = dirty[i];
+            for (int y = dirty[i].y0; y < dirty[i].y1; y++) {
+                memset(index_fb + y * LCD_WIDTH + dirty[i].x0, 0, dirty[i].x1 - dirty[i].x0);
+            }
+            if (recorded) {
+                dl_replay(&dirty[i]);
+            } else {
+                render_fn(render_arg);
+            }
+        }
+        index_clip = (dirty_rect_t){0, 0, LCD_WIDTH, LCD_HEIGHT};
+        index_rendering = false;
+    }
+    
+    if (index_touched.x0 < index_touched.x1) {
+        lcd_invalidate(index_touched.x0, index_touched.y0,
+                       index_touched.x1 - index_touched.x0,
+                       index_touched.y1 - index_touched.y0);
+        index_touched = (dirty_rect_t){0, 0, 0, 0};
+        frame_stats.rects = dirty_count;
+    }
+    if (palette_dirty) {
+        dirty[0] = (dirty_rect_t){0, 0, LCD_WIDTH, LCD_HEIGHT};
+        dirty_count = 1;
+        palette_dirty = false;
+        frame_stats.rects = 1;
+    }
+    
+    for (int i = 0; i < dirty_count; i++) {
+        int x = dirty[i].x0;
+        int w = dirty[i].x1 - dirty[i].x0;
+        int rows = LCD_DMA_PIXELS / w;
+        
+        for (int y = dirty[i].y0; y < dirty[i].y1; y += rows) {
+            int h = (y + rows > dirty[i].y1) ? dirty[i].y1 - y : rows;
+            
+            uint16_t *buf = lcd_strip_acquire();
+            for (int row = y; row < y + h; row++) {
+                const uint8_t *src = index_fb + row * LCD_WIDTH + x;
+                for (int col = 0; col < w; col++) {
+                    *buf++ = palette_wire[src[col]];
+                }
+            }
+            lcd_strip_submit(x, y, w, h);
+        }
+    }
+    lcd_strip_finish();
+}
+
+void lcd_flush(void) {
+    lcd_stats_t before = stats;
+    EBADGE_TRACE_BEGIN(EBADGE_TRACE_LCD_FLUSH, dirty_count);
+    
+    memset(&frame_stats, 0, sizeof(frame_stats));
+    frame_stats.rects = dirty_count;
+    frame_stats.collapsed = dirty_collapsed;
+    
+    if (index_fb != NULL) {
+        index_flush();
+    } else if (render_fn != NULL && dirty_count > 0) {
+        bool recorded = dl_build();
+        for (int i = 0; i < dirty_count; i++) {
+            int x = dirty[i].x0;
+            int w = dirty[i].x1 - dirty[i].x0;
+            int rows = LCD_DMA_PIXELS / w;
+            
+            for (int y = dirty[i].y0; y < dirty[i].y1; y += rows) {
+                int h = (y + rows > dirty[i].y1) ? dirty[i].y1 - y : rows;
+                
+                uint16_t *buf = lcd_strip_acquire();
+                
+                // Strips start out black; the callback paints everything on top
+                memset(buf, 0, w * h * sizeof(uint16_t));
+                target.buf = buf;
+                target.x = x;
+                target.y = y;
+                target.w = w;
+                target.h = h;
+                if (recorded) {
+                    dirty_rect_t area = {x, y, x + w, y + h};
+                    dl_replay(&area);
+                } else {
+                    render_fn(render_arg);
+                }
+                target.buf = NULL;
+                
+                lcd_strip_submit(x, y, w, h);
+            }
+        }
+        lcd_strip_finish();
+    }
+    if (index_fb != NULL || render_fn != NULL) {
+        // Everything stale was invalidated and has now been sent whole
+        shadow_stale = (dirty_rect_t){0, 0, 0, 0};
+    }
+    dirty_count = 0;
+    dirty_collapsed = false;
+    
+    frame_stats.transactions = stats.transactions - before.transactions;
+    frame_stats.bytes = stats.bytes - before.bytes;
+    EBADGE_TRACE_END(EBADGE_TRACE_LCD_FLUSH, frame_stats.bytes);
+}
+
+void lcd_get_frame_stats(lcd_frame_stats_t *out) {
+    *out = frame_stats;
+}
+
+void lcd_get_stats(lcd_stats_t *out) {
+    *out = stats;
+}
+
+void lcd_reset_stats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
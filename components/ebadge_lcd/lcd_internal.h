@@ -0,0 +1,22 @@
+/**
+ * @file lcd_internal.h
+ * @brief Strip pipeline shared between the LCD driver's source files
+ */
+
+#ifndef LCD_INTERNAL_H
+#define LCD_INTERNAL_H
+
+#include <stdint.h>
+
+// Strips are LCD_WIDTH x LCD_DMA_LINES pixels at most
+#define LCD_DMA_LINES      16
+#define LCD_DMA_PIXELS     (LCD_WIDTH * LCD_DMA_LINES)
+
+// Ping-pong strip buffers: fill the buffer from lcd_strip_acquire with up to
+// LCD_DMA_PIXELS wire-order pixels, then queue it with lcd_strip_submit while
+// the next one is prepared. lcd_strip_finish waits until all have been sent.
+uint16_t *lcd_strip_acquire(void);
+void lcd_strip_submit(int x, int y, int w, int h);
+void lcd_strip_finish(void);
+
+#endif // LCD_INTERNAL_H
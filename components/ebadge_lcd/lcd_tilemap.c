@@ -0,0 +1,152 @@
+/**
+ * @file lcd_tilemap.c
+ * @brief Tile-map layer for grid games
+ */
+
+#include "lcd_tilemap.h"
+#include "lcd_internal.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "lcd_tilemap";
+
+static inline bool cell_dirty(const lcd_tilemap_t *map, int i) {
+    return (map->dirty[i / 32] >> (i % 32)) & 1;
+}
+
+static inline void cell_mark(lcd_tilemap_t *map, int i) {
+    map->dirty[i / 32] |= 1u << (i % 32);
+}
+
+static inline const uint16_t *tile_image(const lcd_tilemap_t *map, uint8_t id) {
+    return map->images + id * LCD_TILE_PIXELS;
+}
+
+esp_err_t lcd_tilemap_init(lcd_tilemap_t *map, int x, int y, int cols, int rows, int image_count) {
+    memset(map, 0, sizeof(*map));
+    if (x < 0 || y < 0 || cols <= 0 || rows <= 0 || image_count <= 0 || image_count > 256 ||
+        x + cols * LCD_TILE_SIZE > LCD_WIDTH || y + rows * LCD_TILE_SIZE > LCD_HEIGHT) {
+        ESP_LOGE(TAG, "Bad tile map geometry %dx%d at (%d, %d)", cols, rows, x, y);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    int cells = cols * rows;
+    map->cells = heap_caps_malloc(cells, MALLOC_CAP_8BIT);
+    map->dirty = heap_caps_malloc((cells + 31) / 32 * sizeof(uint32_t), MALLOC_CAP_8BIT);
+    map->images = heap_caps_malloc(image_count * LCD_TILE_PIXELS * sizeof(uint16_t), MALLOC_CAP_8BIT);
+    if (map->cells == NULL || map->dirty == NULL || map->images == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %dx%d tile map", cols, rows);
+        lcd_tilemap_deinit(map);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    map->x = x;
+    map->y = y;
+    map->cols = cols;
+    map->rows = rows;
+    map->image_count = image_count;
+    memset(map->cells, 0, cells);
+    memset(map->images, 0, image_count * LCD_TILE_PIXELS * sizeof(uint16_t));
+    lcd_tilemap_mark_all(map);
+    return ESP_OK;
+}
+
+void lcd_tilemap_deinit(lcd_tilemap_t *map) {
+    heap_caps_free(map->cells);
+    heap_caps_free(map->dirty);
+    heap_caps_free(map->images);
+    memset(map, 0, sizeof(*map));
+}
+
+void lcd_tilemap_define(lcd_tilemap_t *map, uint8_t id, lcd_render_fn_t draw, void *arg) {
+    if (id >= map->image_count) return;
+    lcd_render_to(map->images + id * LCD_TILE_PIXELS, LCD_TILE_SIZE, LCD_TILE_SIZE, draw, arg);
+    
+    // Cells already showing this tile need the new image
+    for (int i = 0; i < map->cols * map->rows; i++) {
+        if (map->cells[i] == id) cell_mark(map, i);
+    }
+}
+
+void lcd_tilemap_set(lcd_tilemap_t *map, int col, int row, uint8_t id) {
+    if (col < 0 || col >= map->cols || row < 0 || row >= map->rows) return;
+    if (id >= map->image_count) id = 0;
+    
+    int i = row * map->cols + col;
+    if (map->cells[i] != id) {
+        map->cells[i] = id;
+        cell_mark(map, i);
+    }
+}
+
+void lcd_tilemap_mark_all(lcd_tilemap_t *map) {
+    memset(map->dirty, 0xFF, (map->cols * map->rows + 31) / 32 * sizeof(uint32_t));
+}
+
+// Find the next run of dirty cells in `row` starting at *col, clearing their
+// bits. Returns the run length, 0 when the row has no more dirty cells.
+static int next_run(lcd_tilemap_t *map, int row, int *col) {
+    int c = *col;
+    int base = row * map->cols;
+    while (c < map->cols && !cell_dirty(map, base + c)) c++;
+    
+    int start = c;
+    while (c < map->cols && cell_dirty(map, base + c)) {
+        map->dirty[(base + c) / 32] &= ~(1u << ((base + c) % 32));
+        c++;
+    }
+    *col = start;
+    return c - start;
+}
+
+void lcd_tilemap_flush(lcd_tilemap_t *map) {
+    bool sent = false;
+    for (int row = 0; row < map->rows; row++) {
+        int col = 0;
+        int len;
+        while ((len = next_run(map, row, &col)) > 0) {
+            // A run is at most LCD_WIDTH x LCD_TILE_SIZE pixels, well inside a strip
+            int w = len * LCD_TILE_SIZE;
+            uint16_t *buf = lcd_strip_acquire();
+            for (int py = 0; py < LCD_TILE_SIZE; py++) {
+                uint16_t *dst = buf + py * w;
+                for (int k = 0; k < len; k++) {
+                    const uint16_t *src = tile_image(map, map->cells[row * map->cols + col + k]);
+                    memcpy(dst + k * LCD_TILE_SIZE, src + py * LCD_TILE_SIZE,
+                           LCD_TILE_SIZE * sizeof(uint16_t));
+                }
+            }
+            lcd_strip_submit(map->x + col * LCD_TILE_SIZE, map->y + row * LCD_TILE_SIZE,
+                             w, LCD_TILE_SIZE);
+            sent = true;
+            col += len;
+        }
+    }
+    if (sent) {
+        lcd_strip_finish();
+    }
+}
+
+void lcd_tilemap_invalidate(lcd_tilemap_t *map) {
+    for (int row = 0; row < map->rows; row++) {
+        int col = 0;
+        int len;
+        while ((len = next_run(map, row, &col)) > 0) {
+            lcd_invalidate(map->x + col * LCD_TILE_SIZE, map->y + row * LCD_TILE_SIZE,
+                           len * LCD_TILE_SIZE, LCD_TILE_SIZE);
+            col += len;
+        }
+    }
+}
+
+void lcd_tilemap_draw(const lcd_tilemap_t *map) {
+    for (int row = 0; row < map->rows; row++) {
+        for (int col = 0; col < map->cols; col++) {
+            lcd_draw_bitmap(map->x + col * LCD_TILE_SIZE, map->y + row * LCD_TILE_SIZE,
+                            LCD_TILE_SIZE, LCD_TILE_SIZE,
+                            tile_image(map, map->cells[row * map->cols + col]));
+        }
+    }
+}
@@ -0,0 +1,45 @@
+# Included by ESP-IDF into the project, so any component can turn PNGs into
+# sprites at build time:
+#
+#   ebadge_lcd_add_sprites(${COMPONENT_LIB} my_sprites sprites/a.png sprites/b.png)
+#
+# generates my_sprites.c/.h in the component's build directory, compiles the
+# source into the target and puts the header on its include path. Pass
+# KEY RRGGBB to make that color transparent as well as alpha < 128.
+# A global property, since IDF does not promise this file's variables reach
+# component scope
+set_property(GLOBAL PROPERTY EBADGE_LCD_TOOLS_DIR ${CMAKE_CURRENT_LIST_DIR}/tools)
+
+function(ebadge_lcd_add_sprites target name)
+    cmake_parse_arguments(arg "" "KEY" "" ${ARGN})
+    get_property(tools GLOBAL PROPERTY EBADGE_LCD_TOOLS_DIR)
+    
+    if(COMMAND idf_build_get_property)
+        idf_build_get_property(python PYTHON)
+    else()
+        find_package(Python3 REQUIRED COMPONENTS Interpreter)
+        set(python ${Python3_EXECUTABLE})
+    endif()
+    
+    set(pngs)
+    foreach(png ${arg_UNPARSED_ARGUMENTS})
+        get_filename_component(png ${png} ABSOLUTE BASE_DIR ${CMAKE_CURRENT_SOURCE_DIR})
+        list(APPEND pngs ${png})
+    endforeach()
+    
+    set(key_option)
+    if(arg_KEY)
+        set(key_option --key ${arg_KEY})
+    endif()
+    
+    set(out ${CMAKE_CURRENT_BINARY_DIR}/${name})
+    add_custom_command(
+        OUTPUT ${out}.c ${out}.h
+        COMMAND ${python} ${tools}/png2sprite.py ${key_option} -o ${out} ${pngs}
+        DEPENDS ${tools}/png2sprite.py ${pngs}
+        COMMENT "Converting sprites for ${name}"
+        VERBATIM
+    )
+    target_sources(${target} PRIVATE ${out}.c)
+    target_include_directories(${target} PRIVATE ${CMAKE_CURRENT_BINARY_DIR})
+endfunction()
@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+"""
+Convert PNG images into RLE sprites for lcd_draw_sprite.
+
+Usage:
+    python3 png2sprite.py [--key RRGGBB] -o out/base image.png [image.png ...]
+
+Writes out/base.c and out/base.h. Each image becomes
+`const lcd_sprite_t sprite_<name>`, where <name> is the file name without
+its extension. Pixels with alpha below 128, or matching the --key color,
+are transparent and cost nothing to draw.
+
+Sprite data is a stream of 16-bit words. Each row is a list of runs and
+ends with a zero word. A run starts with a header word: transparent pixels
+to skip in the high byte, then a fill flag (0x80) and a pixel count of up to
+127. A fill run is followed by one RGB565 color repeated count times, any
+other run by count colors.
+
+Only the standard library is used, so this runs with the ESP-IDF Python.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+PNG_SIGNATURE = b"\x89PNG\r\n\x1a\n"
+MAX_COUNT = 127
+FILL = 0x80
+MIN_FILL = 3  # Shorter repeats are cheaper as literals
+MAX_WIDTH = 255
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def unfilter(raw, width, height, bpp, stride):
+    """Undo the per-row PNG filters, returning a list of row bytearrays."""
+    rows = []
+    prev = bytearray(stride)
+    pos = 0
+    for _ in range(height):
+        ftype = raw[pos]
+        row = bytearray(raw[pos + 1:pos + 1 + stride])
+        pos += 1 + stride
+        for i in range(stride):
+            a = row[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if ftype == 1:
+                row[i] = (row[i] + a) & 0xFF
+            elif ftype == 2:
+                row[i] = (row[i] + b) & 0xFF
+            elif ftype == 3:
+                row[i] = (row[i] + ((a + b) >> 1)) & 0xFF
+            elif ftype == 4:
+                row[i] = (row[i] + paeth(a, b, c)) & 0xFF
+            elif ftype != 0:
+                raise ValueError("bad filter type %d" % ftype)
+        rows.append(row)
+        prev = row
+    return rows
+
+
+def read_png(path):
+    """Return (width, height, rows of (r, g, b, a) tuples)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data.startswith(PNG_SIGNATURE):
+        raise ValueError("not a PNG file")
+
+    pos = len(PNG_SIGNATURE)
+    idat = b""
+    palette = []
+    trns = b""
+    while pos < len(data):
+        length, ctype = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if ctype == b"IHDR":
+            width, height, depth, color, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif ctype == b"PLTE":
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif ctype == b"tRNS":
+            trns = body
+        elif ctype == b"IDAT":
+            idat += body
+        elif ctype == b"IEND":
+            break
+
+    if interlace:
+        raise ValueError("interlaced PNGs are not supported")
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}.get(color)
+    if channels is None:
+        raise ValueError("unsupported color type %d" % color)
+    if depth != 8 and not (color == 3 and depth in (1, 2, 4)):
+        raise ValueError("unsupported bit depth %d" % depth)
+
+    bits = channels * depth
+    stride = (width * bits + 7) // 8
+    rows = unfilter(zlib.decompress(idat), width, height, max(1, bits // 8), stride)
+
+    pixels = []
+    for row in rows:
+        out = []
+        for x in range(width):
+            if color == 3:
+                per_byte = 8 // depth
+                shift = 8 - depth * (x % per_byte + 1)
+                index = (row[x // per_byte] >> shift) & ((1 << depth) - 1)
+                alpha = trns[index] if index < len(trns) else 255
+                out.append(palette[index] + (alpha,))
+            elif color == 0:
+                v = row[x]
+                out.append((v, v, v, 255))
+            elif color == 4:
+                v = row[2 * x]
+                out.append((v, v, v, row[2 * x + 1]))
+            elif color == 2:
+                out.append(tuple(row[3 * x:3 * x + 3]) + (255,))
+            else:
+                out.append(tuple(row[4 * x:4 * x + 4]))
+        pixels.append(out)
+    return width, height, pixels
+
+
+def rgb565(r, g, b):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def is_clear(pixel, key):
+    return pixel[3] < 128 or pixel[:3] == key
+
+
+def encode_span(colors):
+    """Split an opaque span into fill and literal runs of (flag, colors)."""
+    runs = []
+    literal = []
+    i = 0
+    while i < len(colors):
+        n = 1
+        while i + n < len(colors) and colors[i + n] == colors[i] and n < MAX_COUNT:
+            n += 1
+        if n >= MIN_FILL:
+            if literal:
+                runs.append((0, literal))
+                literal = []
+            runs.append((FILL, colors[i:i + n]))
+        else:
+            literal.extend(colors[i:i + n])
+        i += n
+    if literal:
+        runs.append((0, literal))
+
+    # Literal runs longer than the count field allows are split
+    out = []
+    for flag, run in runs:
+        for j in range(0, len(run), MAX_COUNT):
+            out.append((flag, run[j:j + MAX_COUNT]))
+    return out
+
+
+def encode(width, pixels, key):
+    """RLE-encode the image into a list of 16-bit words."""
+    words = []
+    for row in pixels:
+        x = 0
+        while x < width:
+            skip = 0
+            while x < width and is_clear(row[x], key):
+                x += 1
+                skip += 1
+            if x == width:
+                break
+            start = x
+            while x < width and not is_clear(row[x], key):
+                x += 1
+            span = [rgb565(*p[:3]) for p in row[start:x]]
+            for flag, run in encode_span(span):
+                words.append(skip << 8 | flag | len(run))
+                words.extend(run[:1] if flag else run)
+                skip = 0
+        words.append(0)
+    return words
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert PNGs into RLE sprites")
+    parser.add_argument("-o", "--output", required=True, help="output path without extension")
+    parser.add_argument("--key", help="transparent color as RRGGBB")
+    parser.add_argument("images", nargs="+")
+    args = parser.parse_args()
+
+    key = None
+    if args.key:
+        key = tuple(bytes.fromhex(args.key))
+
+    base = os.path.basename(args.output)
+    guard = re.sub(r"\W", "_", base).upper() + "_H"
+    source = ['// Generated by png2sprite.py, do not edit', '',
+              '#include "%s.h"' % base, '']
+    header = ['// Generated by png2sprite.py, do not edit', '',
+              '#ifndef %s' % guard, '#define %s' % guard, '',
+              '#include "lcd_driver.h"', '']
+
+    for path in args.images:
+        name = re.sub(r"\W", "_", os.path.splitext(os.path.basename(path))[0])
+        try:
+            width, height, pixels = read_png(path)
+        except (ValueError, OSError, zlib.error) as e:
+            sys.exit("%s: %s" % (path, e))
+        if width > MAX_WIDTH or height > 0xFFFF:
+            sys.exit("%s: sprites are limited to %d pixels wide" % (path, MAX_WIDTH))
+
+        words = encode(width, pixels, key)
+        source.append("static const uint16_t sprite_%s_data[%d] = {" % (name, len(words)))
+        for i in range(0, len(words), 12):
+            source.append("    " + " ".join("0x%04X," % w for w in words[i:i + 12]))
+        source.append("};")
+        source.append("const lcd_sprite_t sprite_%s = {%d, %d, sprite_%s_data};"
+                      % (name, width, height, name))
+        source.append("")
+        header.append("extern const lcd_sprite_t sprite_%s;  // %dx%d, %d bytes"
+                      % (name, width, height, len(words) * 2))
+
+    header += ["", "#endif // %s" % guard, ""]
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output + ".c", "w") as f:
+        f.write("\n".join(source))
+    with open(args.output + ".h", "w") as f:
+        f.write("\n".join(header))
+
+
+if __name__ == "__main__":
+    main()
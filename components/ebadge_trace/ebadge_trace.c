@@ -0,0 +1,239 @@
+/**
+ * @file ebadge_trace.c
+ * @brief Event trace ring buffer, dumped over the console for a timeline view
+ */
+
+#include "ebadge_trace.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "trace";
+
+#if CONFIG_EBADGE_TRACE
+
+#define TRACE_EVENTS      CONFIG_EBADGE_TRACE_EVENTS
+#define TRACE_TASKS       16    // Tasks named in the dump; later ones share the last slot
+#define TRACE_NAME_LEN    16
+#define TRACE_VERSION     1
+#define TRACE_ESCAPE      0x1B
+#define TRACE_REQUEST     "trace"
+#define TRACE_LISTEN_MS   100
+
+_Static_assert((TRACE_EVENTS & (TRACE_EVENTS - 1)) == 0, "trace ring size must be a power of two");
+
+typedef struct {
+    uint32_t time_us;  // Low 32 bits of esp_timer_get_time
+    uint32_t arg;
+    uint8_t id;
+    uint8_t phase;
+    uint8_t task;      // Index into the task table
+    uint8_t core;
+} trace_event_t;
+
+static const char *const id_names[EBADGE_TRACE_IDS] = {
+    [EBADGE_TRACE_LCD_FLUSH] = "lcd_flush",
+    [EBADGE_TRACE_LCD_SPI_WAIT] = "spi_wait",
+    [EBADGE_TRACE_GAME_INPUT] = "input",
+    [EBADGE_TRACE_GAME_UPDATE] = "update",
+    [EBADGE_TRACE_GAME_RENDER] = "render",
+    [EBADGE_TRACE_OTA_CHUNK] = "ota_chunk",
+    [EBADGE_TRACE_WIFI_EVENT] = "wifi_event",
+    [EBADGE_TRACE_IP_EVENT] = "ip_event",
+};
+
+static trace_event_t ring[TRACE_EVENTS];
+static atomic_uint head;      // Events claimed so far; slot is head % TRACE_EVENTS
+static atomic_bool paused;
+
+// Tasks get a small index the first time they record
+static TaskHandle_t tasks[TRACE_TASKS];
+static char task_names[TRACE_TASKS][TRACE_NAME_LEN];
+static atomic_uint task_count;
+static portMUX_TYPE task_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint8_t task_index(void) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    unsigned n = atomic_load_explicit(&task_count, memory_order_acquire);
+    for (unsigned i = 0; i < n; i++) {
+        if (tasks[i] == self) {
+            return i;
+        }
+    }
+
+    // First event from this task; the other core may be adding one too
+    taskENTER_CRITICAL(&task_lock);
+    unsigned i = atomic_load_explicit(&task_count, memory_order_relaxed);
+    if (i < TRACE_TASKS) {
+        tasks[i] = self;
+        strlcpy(task_names[i], pcTaskGetName(self), TRACE_NAME_LEN);
+        atomic_store_explicit(&task_count, i + 1, memory_order_release);
+    } else {
+        i = TRACE_TASKS - 1;
+    }
+    taskEXIT_CRITICAL(&task_lock);
+    return i;
+}
+
+void ebadge_trace_record(ebadge_trace_id_t id, ebadge_trace_phase_t phase, uint32_t arg) {
+    if (atomic_load_explicit(&paused, memory_order_relaxed)) {
+        return;
+    }
+    unsigned slot = atomic_fetch_add_explicit(&head, 1, memory_order_relaxed) % TRACE_EVENTS;
+    trace_event_t *e = &ring[slot];
+    e->time_us = (uint32_t)esp_timer_get_time();
+    e->arg = arg;
+    e->id = id;
+    e->phase = phase;
+    e->task = task_index();
+    e->core = xPortGetCoreID();
+}
+
+// The frame goes through the console's text path, which may turn \n into
+// \r\n, so those bytes and the escape itself are sent as ESC, byte ^ 0x40
+typedef struct {
+    uint8_t buf[64];
+    size_t len;
+    uint32_t crc;
+} trace_writer_t;
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t n) {
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static void writer_flush(trace_writer_t *w) {
+    fwrite(w->buf, 1, w->len, stdout);
+    w->len = 0;
+}
+
+static void writer_put(trace_writer_t *w, const void *data, size_t n) {
+    const uint8_t *p = data;
+    w->crc = crc32_update(w->crc, p, n);
+    for (size_t i = 0; i < n; i++) {
+        if (w->len + 2 > sizeof(w->buf)) {
+            writer_flush(w);
+        }
+        if (p[i] == '\n' || p[i] == '\r' || p[i] == TRACE_ESCAPE) {
+            w->buf[w->len++] = TRACE_ESCAPE;
+            w->buf[w->len++] = p[i] ^ 0x40;
+        } else {
+            w->buf[w->len++] = p[i];
+        }
+    }
+}
+
+static void writer_put_name(trace_writer_t *w, const char *name) {
+    uint8_t len = strlen(name);
+    writer_put(w, &len, 1);
+    writer_put(w, name, len);
+}
+
+static void writer_put_u32(trace_writer_t *w, uint32_t v) {
+    uint8_t b[4] = {v, v >> 8, v >> 16, v >> 24};
+    writer_put(w, b, sizeof(b));
+}
+
+void ebadge_trace_dump(void) {
+    atomic_store(&paused, true);
+    vTaskDelay(1);  // Let a record in progress on the other core finish
+
+    unsigned total = atomic_load(&head);
+    unsigned count = (total < TRACE_EVENTS) ? total : TRACE_EVENTS;
+    unsigned first = total - count;
+    unsigned ntasks = atomic_load(&task_count);
+    ESP_LOGI(TAG, "Dumping %u events (%u overwritten)", count, total - count);
+    fflush(stdout);
+
+    // Frame: magic, then escaped payload and CRC-32 of the payload
+    trace_writer_t w = {.len = 0, .crc = 0};
+    fwrite("EBTR", 1, 4, stdout);
+    uint8_t version = TRACE_VERSION;
+    writer_put(&w, &version, 1);
+
+    uint8_t n = EBADGE_TRACE_IDS;
+    writer_put(&w, &n, 1);
+    for (int i = 0; i < EBADGE_TRACE_IDS; i++) {
+        writer_put_name(&w, id_names[i]);
+    }
+    n = ntasks;
+    writer_put(&w, &n, 1);
+    for (unsigned i = 0; i < ntasks; i++) {
+        writer_put_name(&w, task_names[i]);
+    }
+
+    writer_put_u32(&w, count);
+    writer_put_u32(&w, total - count);
+    for (unsigned i = 0; i < count; i++) {
+        const trace_event_t *e = &ring[(first + i) % TRACE_EVENTS];
+        writer_put_u32(&w, e->time_us);
+        writer_put_u32(&w, e->arg);
+        uint8_t b[4] = {e->id, e->phase, e->task, e->core};
+        writer_put(&w, b, sizeof(b));
+    }
+
+    uint32_t crc = w.crc;
+    writer_put_u32(&w, crc);
+    writer_flush(&w);
+    fputc('\n', stdout);
+    fflush(stdout);
+
+    atomic_store(&paused, false);
+}
+
+// Console reads do not block, so the listener polls a few times a second
+static void listen_task(void *param) {
+    size_t matched = 0;
+    while (1) {
+        int c = fgetc(stdin);
+        if (c == EOF) {
+            clearerr(stdin);
+            vTaskDelay(pdMS_TO_TICKS(TRACE_LISTEN_MS));
+            continue;
+        }
+        if (c == TRACE_REQUEST[matched]) {
+            matched++;
+        } else {
+            matched = (c == TRACE_REQUEST[0]) ? 1 : 0;
+        }
+        if (matched == strlen(TRACE_REQUEST)) {
+            ebadge_trace_dump();
+            matched = 0;
+        }
+    }
+}
+
+esp_err_t ebadge_trace_init(void) {
+    if (xTaskCreate(listen_task, "trace", 3072, NULL, 1, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create listener task");
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Recording %d events; type \"%s\" to dump", TRACE_EVENTS, TRACE_REQUEST);
+    return ESP_OK;
+}
+
+#else
+
+void ebadge_trace_record(ebadge_trace_id_t id, ebadge_trace_phase_t phase, uint32_t arg) {
+}
+
+esp_err_t ebadge_trace_init(void) {
+    return ESP_OK;
+}
+
+void ebadge_trace_dump(void) {
+    ESP_LOGW(TAG, "Tracing is disabled (CONFIG_EBADGE_TRACE)");
+}
+
+#endif
@@ -0,0 +1,59 @@
+/**
+ * @file ebadge_trace.h
+ * @brief Event trace ring buffer, dumped over the console for a timeline view
+ */
+
+#ifndef EBADGE_TRACE_H
+#define EBADGE_TRACE_H
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+// Each event is a microsecond timestamp, an ID, a phase and a 32-bit
+// argument, written into a fixed RAM ring that keeps the newest
+// CONFIG_EBADGE_TRACE_EVENTS. Recording costs a timer read and an atomic
+// increment. Typing "trace" on the console dumps the ring as a binary frame;
+// tools/trace2json.py turns that into Chrome trace_event JSON, for
+// chrome://tracing or ui.perfetto.dev.
+
+// New IDs go at the end; tools/trace2json.py reads the names from the dump
+typedef enum {
+    EBADGE_TRACE_LCD_FLUSH,     // Begin: dirty rects; end: bytes sent
+    EBADGE_TRACE_LCD_SPI_WAIT,  // Blocked on queued SPI transfers; arg: count
+    EBADGE_TRACE_GAME_INPUT,    // Same order as game_profile_phase_t
+    EBADGE_TRACE_GAME_UPDATE,
+    EBADGE_TRACE_GAME_RENDER,
+    EBADGE_TRACE_OTA_CHUNK,     // One download-and-flash step; end: image bytes
+    EBADGE_TRACE_WIFI_EVENT,    // Instant; arg: wifi_event_t
+    EBADGE_TRACE_IP_EVENT,      // Instant; arg: ip_event_t
+    EBADGE_TRACE_IDS
+} ebadge_trace_id_t;
+
+typedef enum {
+    EBADGE_TRACE_PHASE_BEGIN,
+    EBADGE_TRACE_PHASE_END,
+    EBADGE_TRACE_PHASE_INSTANT,
+} ebadge_trace_phase_t;
+
+#if CONFIG_EBADGE_TRACE
+#define EBADGE_TRACE_BEGIN(id, arg)   ebadge_trace_record((id), EBADGE_TRACE_PHASE_BEGIN, (arg))
+#define EBADGE_TRACE_END(id, arg)     ebadge_trace_record((id), EBADGE_TRACE_PHASE_END, (arg))
+#define EBADGE_TRACE_INSTANT(id, arg) ebadge_trace_record((id), EBADGE_TRACE_PHASE_INSTANT, (arg))
+#else
+#define EBADGE_TRACE_BEGIN(id, arg)   ((void)0)
+#define EBADGE_TRACE_END(id, arg)     ((void)0)
+#define EBADGE_TRACE_INSTANT(id, arg) ((void)0)
+#endif
+
+// Task context only; events from an ISR would need their own slot claim
+void ebadge_trace_record(ebadge_trace_id_t id, ebadge_trace_phase_t phase, uint32_t arg);
+
+// Start the console listener that answers "trace" with a dump. Recording
+// works without it.
+esp_err_t ebadge_trace_init(void);
+
+// Write the ring to stdout as one frame. Recording pauses meanwhile.
+void ebadge_trace_dump(void);
+
+#endif // EBADGE_TRACE_H
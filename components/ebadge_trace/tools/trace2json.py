@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""
+Convert an ebadge_trace dump into Chrome trace_event JSON.
+
+Usage:
+    python3 trace2json.py -o trace.json capture.log
+    python3 trace2json.py -o trace.json --port /dev/ttyACM0
+
+The badge answers "trace" on its console with one frame: the magic "EBTR",
+then an escaped payload, then a newline. Inside the payload the bytes \\n,
+\\r and ESC (0x1B) are sent as ESC followed by the byte XOR 0x40, so the
+console's line handling cannot alter it. The unescaped payload is:
+
+    u8 version, u8 id count, names, u8 task count, names,
+    u32 event count, u32 events overwritten,
+    events of {u32 time_us, u32 arg, u8 id, u8 phase, u8 task, u8 core},
+    u32 CRC-32 of everything before it
+
+Names are a length byte and that many characters; integers are
+little-endian. A capture file may hold log text and several frames; the last
+frame that passes its CRC is used. With --port the request is sent over the
+serial line and the reply read directly, which needs pyserial.
+
+Open the output in chrome://tracing or https://ui.perfetto.dev. Each task is
+a track; the 32-bit arg of each event shows up in its args.
+
+Only the standard library is used for files, so this runs with the ESP-IDF
+Python.
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+import zlib
+
+MAGIC = b"EBTR"
+ESCAPE = 0x1B
+VERSION = 1
+EVENT = struct.Struct("<IIBBBB")
+PHASES = {0: "B", 1: "E", 2: "i"}
+
+
+class TraceError(Exception):
+    pass
+
+
+def unescape(data, start):
+    """Unescape from start up to the frame's newline; None if it is cut off."""
+    out = bytearray()
+    i = start
+    while i < len(data):
+        b = data[i]
+        if b == 0x0A:
+            return bytes(out)
+        if b == ESCAPE:
+            if i + 1 >= len(data):
+                return None
+            out.append(data[i + 1] ^ 0x40)
+            i += 2
+        else:
+            out.append(b)
+            i += 1
+    return None
+
+
+class Reader:
+    def __init__(self, payload):
+        self.data = payload
+        self.pos = 0
+
+    def take(self, n):
+        if self.pos + n > len(self.data):
+            raise TraceError("frame is truncated")
+        chunk = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return chunk
+
+    def u8(self):
+        return self.take(1)[0]
+
+    def u32(self):
+        return struct.unpack("<I", self.take(4))[0]
+
+    def names(self):
+        return [self.take(self.u8()).decode("utf-8", "replace") for _ in range(self.u8())]
+
+
+def parse_frame(payload):
+    if len(payload) < 4:
+        raise TraceError("frame is truncated")
+    body, crc = payload[:-4], struct.unpack("<I", payload[-4:])[0]
+    if zlib.crc32(body) != crc:
+        raise TraceError("CRC mismatch")
+
+    r = Reader(body)
+    version = r.u8()
+    if version != VERSION:
+        raise TraceError("unsupported version %d" % version)
+    ids = r.names()
+    tasks = r.names()
+    count = r.u32()
+    lost = r.u32()
+    events = [EVENT.unpack(r.take(EVENT.size)) for _ in range(count)]
+    return ids, tasks, lost, events
+
+
+def find_frame(data):
+    """Return the last complete, valid frame in a capture."""
+    error = TraceError("no trace frame found")
+    pos = data.rfind(MAGIC)
+    while pos >= 0:
+        payload = unescape(data, pos + len(MAGIC))
+        if payload is not None:
+            try:
+                return parse_frame(payload)
+            except TraceError as e:
+                error = e
+        pos = data.rfind(MAGIC, 0, pos)
+    raise error
+
+
+def to_chrome(ids, tasks, events):
+    """Build trace_event JSON, with times relative to the first event."""
+    out = []
+    for tid, name in enumerate(tasks):
+        out.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": tid,
+                    "args": {"name": name}})
+
+    # Timestamps are the low 32 bits of a microsecond clock and wrap every
+    # 71 minutes; events from two cores can be a little out of order
+    base = None
+    last_raw = last = 0
+    for time_us, arg, event_id, phase, task, core in events:
+        if base is None:
+            base = last = time_us
+        else:
+            delta = (time_us - last_raw) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                delta -= 0x100000000
+            last += delta
+        last_raw = time_us
+
+        name = ids[event_id] if event_id < len(ids) else "id%d" % event_id
+        ev = {"name": name, "ph": PHASES.get(phase, "i"), "ts": last - base,
+              "pid": 0, "tid": task, "args": {"arg": arg, "core": core}}
+        if ev["ph"] == "i":
+            ev["s"] = "t"
+        out.append(ev)
+    return {"traceEvents": out, "displayTimeUnit": "ms"}
+
+
+def capture(port, baud, timeout):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("--port needs pyserial (pip install pyserial)")
+
+    data = bytearray()
+    with serial.Serial(port, baud, timeout=0.2) as s:
+        s.reset_input_buffer()
+        s.write(b"trace\n")
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            data += s.read(4096)
+            start = data.find(MAGIC)
+            if start >= 0 and unescape(data, start + len(MAGIC)) is not None:
+                break
+    return bytes(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert an ebadge_trace dump to Chrome JSON")
+    parser.add_argument("-o", "--output", required=True, help="JSON file to write")
+    parser.add_argument("--port", help="serial port to request a dump from")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=10.0, help="seconds to wait with --port")
+    parser.add_argument("capture", nargs="?", help="console log holding a dump")
+    args = parser.parse_args()
+
+    if args.port:
+        data = capture(args.port, args.baud, args.timeout)
+    elif args.capture:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+    else:
+        parser.error("give a capture file or --port")
+
+    try:
+        ids, tasks, lost, events = find_frame(data)
+    except TraceError as e:
+        sys.exit("%s: %s" % (args.port or args.capture, e))
+
+    with open(args.output, "w") as f:
+        json.dump(to_chrome(ids, tasks, events), f)
+    print("%s: %d events from %d tasks, %d overwritten" %
+          (args.output, len(events), len(tasks), lost))
+
+
+if __name__ == "__main__":
+    main()
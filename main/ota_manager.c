@@ -8,6 +8,7 @@
 #include "esp_http_client.h"
 #include "esp_https_ota.h"
 #include "esp_ota_ops.h"
+#include "ebadge_trace.h"
 #include "cJSON.h"
 #include <string.h>
 
@@ -163,7 +164,9 @@ esp_err_t ota_manager_download_and_install(const char *app_url)
 
     // Download and write to partition
     while (1) {
+        EBADGE_TRACE_BEGIN(EBADGE_TRACE_OTA_CHUNK, 0);
         err = esp_https_ota_perform(https_ota_handle);
+        EBADGE_TRACE_END(EBADGE_TRACE_OTA_CHUNK, esp_https_ota_get_image_len_read(https_ota_handle));
         if (err != ESP_ERR_HTTPS_OTA_IN_PROGRESS) {
             break;
         }
@@ -10,6 +10,7 @@
 #include "esp_netif.h"
 #include "esp_netif_ip_addr.h"
 #include "nvs_flash.h"
+#include "ebadge_trace.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include <string.h>
@@ -31,6 +32,8 @@ static int s_retry_num = 0;
 static void event_handler(void* arg, esp_event_base_t event_base,
                          int32_t event_id, void* event_data)
 {
+    EBADGE_TRACE_INSTANT(event_base == IP_EVENT ? EBADGE_TRACE_IP_EVENT : EBADGE_TRACE_WIFI_EVENT,
+                         event_id);
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         esp_wifi_connect();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {